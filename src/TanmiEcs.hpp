@@ -9,9 +9,17 @@
 
 #include <assert.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <functional>
+#include <mutex>
+#include <array>
+#include <deque>
+#include <numeric>
+#include <tuple>
+#include <iterator>
 #include "TanmiEcsTools.hpp"
+#include "TanmiEcsTask.hpp"
 #include "TanmiEcsEvent.hpp"
 
 #define assertm(exp, msg) assert(((void)msg, exp))
@@ -30,6 +38,17 @@ namespace TanmiEngine {
 	class Queryer;		///< ѯ
 	class Event;		///< ¼
 	class EventSystem;	///< ¼ϵͳ
+	class Prefab;		///< Ԥ
+	class StagingWorld;	///< ݴ
+	template<typename ...Components>
+	class Query;		///< ͻѯ
+	template<typename ...Components>
+	class Group;		///< 
+	template<typename T>
+	class Shared;		///< 
+	class TaskContext;	///< Эϵͳ
+	template<typename C>
+	struct RunCondition;	///< ֵʽ
 	using UpdateSystem = void (*)(Command&, Queryer, Resource, Event& event);
 	using StartupSystem = void (*)(Command&, Resource);
 
@@ -41,12 +60,61 @@ namespace TanmiEngine {
 		virtual void Quit(Sence* sence) = 0;
 	};
 
+	/**
+	 * @brief 洢Ƭͳ
+	 */
+	struct StorageStats
+	{
+		size_t columns = 0;		///< 
+		size_t live = 0;		///< ʹе
+		size_t cached = 0;		///< пеĻ
+		size_t scattered = 0;	///< ˳ǰһڵĶ
+		size_t blocks = 0;		///< ڴ
+		/**
+		 * @brief Ƭ, ڶռʹжı
+		 */
+		double Fragmentation()const
+		{
+			return live == 0 ? 0.0 : double(scattered) / double(live);
+		}
+	};
+	/**
+	 * @brief Эϵͳ, ÿλָЭǰɵ
+	 *
+	 * ¼ֻ co_await ֮Ч, Խ co_await »ȡ
+	 */
+	class TaskContext final : public TaskState
+	{
+	public:
+		friend class Sence;
+		TaskContext(Sence& sence) :_sence(sence)
+		{}
+		TaskContext(const TaskContext&) = delete;
+		TaskContext& operator = (const TaskContext&) = delete;
+		Command& GetCommand();
+		Queryer GetQueryer();
+		Resource GetResource();
+		Event& GetEvent();
+	private:
+		Sence& _sence;
+		Command* _cmd = nullptr;	///< ֡Э̵
+		Event* _event = nullptr;	///< ֡¼
+	};
+
 	class Sence final
 	{
 	public:
 		friend class Resource;
 		friend class Command;
 		friend class Queryer;
+		friend class Prefab;
+		friend class StagingWorld;
+		template<typename ...Components>
+		friend class Query;
+		template<typename ...Components>
+		friend class Group;
+		template<typename C>
+		friend struct RunCondition;
 		Sence()
 		{
 			_id = IDGenerator<SenceID>::GetID();
@@ -83,14 +151,123 @@ namespace TanmiEngine {
 		/**
 		 * @brief Ӹϵͳ
 		 *
+		 * ϵͳɵö, עʱƵÿεʱע, òΪ
+		 * Command&, Queryer, Resource, Event&, Query<...>, Group<...>&, Res<T>, EventWriter<T>, EventReader<T>
+		 *  Command  Event Ϊ
+		 *
+		 * ɸ,  ResourceChanged<T>, EventPresent<T>, QueryNonEmpty<...>, AnyChanged<...>, AccessChanged
+		 * 򷵻boolĿɵö, ÿ֡ǰֵ, ȫʱŵϵͳ
+		 *
+		 * ״̬עʱ, ShutDown ʱͷ, ٴ Start ʱ
+		 *
 		 * @param sys ϵͳ
+		 * @param conditions 
+		 * @return 
+		 */
+		template<typename F, typename ...Conditions>
+		Sence& AddUpdateSystem(F&& sys, Conditions&& ...conditions);
+		/**
+		 * @brief Эϵͳ, ڿԽ֡ĳ
+		 *
+		 * ϵͳǩΪ Task(TaskContext&),  co_await NextFrame, TimeSlice  WorkerJob,
+		 * ڸϵͳ֮ÿ֡Ԥָ, Э̽һ֡
+		 * Эδ쳣ڱִ֡, ֡ƽ Update ׳
+		 *
+		 * @param sys ϵͳ
+		 * @return 
+		 */
+		template<typename F>
+		Sence& AddCoroutineSystem(F&& sys);
+		/**
+		 * @brief ÿָ֡ЭϵͳʱԤ, ԤЭƳٵһ֡
+		 *
+		 * @param budget ʱԤ
+		 * @return 
+		 */
+		Sence& SetTaskBudget(std::chrono::microseconds budget)
+		{
+			_task_budget = budget;
+			return *this;
+		}
+		/**
+		 * @brief עʵʱĻص, ʵȫɺ
+		 *
+		 * @param hook ص, ΪʵID
+		 * @return 
+		 */
+		template<typename T>
+		Sence& OnAdd(std::function<void(EntityID, T&)> hook);
+		/**
+		 * @brief ע뿪ʵʱĻص, ǰ
+		 *
+		 * @param hook ص, ΪʵID
+		 * @return 
+		 */
+		template<typename T>
+		Sence& OnRemove(std::function<void(EntityID, T&)> hook);
+		/**
+		 * @brief עڴ洢ƶĻص, ڸ±ַⲿ
+		 *
+		 * @param hook ص, ΪʵIDƶ
+		 * @return 
+		 */
+		template<typename T>
+		Sence& OnMove(std::function<void(EntityID, T&)> hook);
+		/**
+		 * @brief 洢, Ƭаѯı˳ (ʵID˳) ڴ, ͷŶصĿж
+		 *
+		 * а˳, ʹʱڴ
+		 * зֶƶͷ, ÿһڴ; ͳƬʱһ
+		 * ÿεƽһ, ֮󳬳ʱԤ㼴ֹͣ, ´εôֹͣ, е;;
+		 * ε֮ɾʵ, ʼʵԭ, ´
+		 * ֮֡, ϵͳ
+		 *
+		 * @param budget ʱԤ
+		 * @return ȫоѼʱtrue
+		 */
+		bool Defragment(std::chrono::microseconds budget);
+		/**
+		 * @brief ÿ֡ Update ʱ洢ʱԤ, ΪʱԶ
+		 *
+		 * @param budget ʱԤ
+		 * @return 
+		 */
+		Sence& SetDefragBudget(std::chrono::microseconds budget)
+		{
+			_defrag_budget = budget;
+			return *this;
+		}
+		/**
+		 * @brief ÿ֡ Update ʼʱݴʱԤ, Ϊʱһβȫ
+		 *
+		 * ԤʵƳٵһ֡, ÿβʵ嶼ȫ, ʵIDһβʱͬ;
+		 * ָǰɽеݴ
+		 *
+		 * @param budget ʱԤ
 		 * @return 
 		 */
-		Sence& AddUpdateSystem(UpdateSystem sys)
+		Sence& SetMergeBudget(std::chrono::microseconds budget)
 		{
-			_updateSystems.push_back(sys);
+			_merge_budget = budget;
 			return *this;
 		}
+		/**
+		 * @brief ȡȫеƬͳ
+		 */
+		StorageStats GetStorageStats();
+		/**
+		 * @brief ȡһƬͳ
+		 */
+		template<typename T>
+		StorageStats GetStorageStats();
+		/**
+		 * @brief עԤ, Ԥȷ, Ŀ洢Ĭֵ
+		 *
+		 * @param components ԤĬ
+		 * @return Ԥ
+		 */
+		template<typename ...ComponentTypes>
+		Prefab MakePrefab(ComponentTypes&& ...components);
 		template<typename T, typename ...Args>
 		Sence& AddPlugin(Args&& ...args)
 		{
@@ -108,6 +285,92 @@ namespace TanmiEngine {
 		 */
 		void Update();
 
+		/**
+		 * @brief ȡ, ״λȡʱ, ֮ɾά
+		 *
+		 * @tparam Components 
+		 * @return 
+		 */
+		template<typename ...Components>
+		Group<Components...>& GetGroup();
+		/**
+		 * @brief ȡ, ֵͬĹָͬһ
+		 *
+		 * Ϊͨʵ, ÿʵֻһ, һͷʱ֮ͷ
+		 * ̵߳, ں̨߳ݴʱ
+		 *
+		 * @param value ֵ
+		 * @return 
+		 */
+		template<typename T>
+		Shared<std::decay_t<T>> Share(T&& value);
+		/**
+		 * @brief ȡһ๲ǰֵͬ
+		 */
+		template<typename T>
+		size_t SharedCount();
+		/**
+		 * @brief ύݴ, һ Update ʼʱ볡
+		 *
+		 * ̵߳, ݴֱƽ, ´
+		 * ʱ߳ΪÿݴһĳʵID, ݴ簴ύ˳
+		 *
+		 * @param staging ݴ
+		 */
+		void Splice(StagingWorld&& staging);
+		/**
+		 * @brief ñļ
+		 *
+		 * @param depth 
+		 * @return 
+		 */
+		Sence& SetCheckpointDepth(size_t depth)
+		{
+			_checkpoint_depth = depth;
+			while (_checkpoints.size() > _checkpoint_depth)
+			{
+				_checkpoints.pop_front();
+			}
+			return *this;
+		}
+		/**
+		 * @brief 浱ǰ֡ļ
+		 *
+		 * ֻһ仯, δ仯һ㹲; ˳һ
+		 * ޸辭 Queryer::GetComponent д Query Żᱻ¼
+		 * Դֻھ CheckpointResource ڼ, ¼ڼ
+		 *
+		 * @return Ӧ֡
+		 */
+		int SaveCheckpoint();
+		/**
+		 * @brief ָָ֡ļ, ֮֡ļ㱻
+		 *
+		 * ʵIDһָ, ͬһطʱɵʵIDһ
+		 * ֻɾ㲻ͬʵ; ѯʵID˳, ָʱ˳, طʱı˳״ͬ
+		 *
+		 * @param frame ֡
+		 * @return Ƿڸ֡ļ
+		 */
+		bool RestoreCheckpoint(int frame);
+		/**
+		 * @brief Դ, ָʱԴصʱֵ
+		 *
+		 * ÿα㶼Դ, ʺϼʱ, ״̬ȽС״̬; Դɸ
+		 * ʱԴδõ, ָʱƳԴ
+		 *
+		 * @tparam T Դ
+		 * @return 
+		 */
+		template<typename T>
+		Sence& CheckpointResource();
+		/**
+		 * @brief ȡǰ֡
+		 */
+		int GetFrame()const
+		{
+			return _frame;
+		}
 		/**
 		 * @brief ֹ
 		 */
@@ -117,9 +380,26 @@ namespace TanmiEngine {
 			{
 				plugin->Quit(this);
 			}
+			// ϵͳĲ״̬ĵַ, ͷ, ٴ Start ʱ
+			for (auto& sys : _updateSystems)
+			{
+				sys.Release();
+			}
+			for (auto& task : _tasks)
+			{
+				task->task.Reset();
+				task->start_frame = 0;
+			}
+			_compact.reset();
+			AbortMerge();
 			_entitys.clear();
 			_resources.clear();
+			_checkpoints.clear();
+			_groups.clear();
+			_prefabs.clear();
 			_components.clear();
+			std::lock_guard<std::mutex> lock(_shared_mutex);
+			_shared.clear();
 		}
 	private:
 		/**
@@ -127,12 +407,418 @@ namespace TanmiEngine {
 		 */
 		struct ComponentInfo
 		{
+			using HookFunc = std::function<void(EntityID, void*)>;
+			using Tick = ChangeTick::Tick;
 			Pool pool;
+			const ComponentOps* ops = nullptr;	///< 
 			std::unordered_map<EntityID, void*> entity_map;	///< ӵʵ
-			ComponentInfo(createFunc crt, destoryFunc des) :pool(crt, des)
+			std::vector<std::pair<EntityID, void*>> rows;	///< ʵIDеʵ, ѯ˳
+			size_t sorted = 0;		///< rows ǰ, Ϊ¼
+			size_t removed = 0;		///< rows Ƴѹ, Ϊ
+			std::vector<HookFunc> on_add;		///< ʵʱĻص
+			std::vector<HookFunc> on_remove;	///< 뿪ʵʱĻص
+			std::vector<HookFunc> on_move;		///< ڴ洢ƶĻص
+			Tick version = 0;		///< һα仯ʱ, ж
+			Tick state = 0;			///< ݵıʶ, ָͬ, жǷһ
+			Tick structure = 0;		///< ӵʵ弯ϵıʶ, ָͬ
+			Tick layout = 0;		///< һμ洢ʱstructure
+			ComponentInfo(const ComponentOps* op) :pool(op->create, op->destory, op->recycle), ops(op)
 			{}
 			ComponentInfo() :pool(nullptr, nullptr)
 			{}
+			/**
+			 * @brief ݿܱ޸
+			 */
+			void MarkChanged()
+			{
+				version = state = ChangeTick::Next();
+			}
+			/**
+			 * @brief ӵʵ弯Ϸ仯
+			 */
+			void MarkStructure()
+			{
+				structure = version = state = ChangeTick::Next();
+			}
+			/**
+			 * @brief Ϊʵ, ʵиʱ滻
+			 *
+			 * @param entity ʵ
+			 * @param elem 
+			 */
+			void Insert(EntityID entity, void* elem)
+			{
+				auto [it, inserted] = entity_map.insert_or_assign(entity, elem);
+				if (!inserted)
+				{
+					FindRow(entity)->second = elem;
+					return;
+				}
+				// ʵIDͨ, ֱӽ򲿷֮
+				if (sorted == rows.size() && (rows.empty() || rows.back().first < entity))
+				{
+					sorted++;
+				}
+				rows.emplace_back(entity, elem);
+			}
+			/**
+			 * @brief ΪʵԤ, ȱٵĶһηΪڴ
+			 *
+			 * @param count ʵ
+			 */
+			void Reserve(size_t count)
+			{
+				constexpr size_t min_block = 64;
+				ReserveMore(entity_map, count);
+				ReserveMore(rows, count);
+				ReserveMore(pool.instances, count);
+				if (pool.cache.size() >= count)
+				{
+					return;
+				}
+				size_t missing = count - pool.cache.size();
+				if (missing < min_block)
+				{
+					pool.reserve(count);
+					return;
+				}
+				void* block = ops->create_array(missing);
+				pool.blocks.emplace_back(static_cast<char*>(block), static_cast<char*>(block) + missing * ops->size);
+				// create ӻβȡ, ʹʵַ
+				for (size_t i = missing; i-- > 0;)
+				{
+					pool.cache.push_back(ops->At(block, i));
+				}
+			}
+			/**
+			 * @brief Ƴʵ, Ӧȱ, ´αʱͳһѹ
+			 *
+			 * @param entity ʵ
+			 * @return Ƴ, ʵûиʱΪ
+			 */
+			void* Erase(EntityID entity)
+			{
+				auto it = entity_map.find(entity);
+				if (it == entity_map.end())
+				{
+					return nullptr;
+				}
+				void* elem = it->second;
+				entity_map.erase(it);
+				FindRow(entity)->second = nullptr;
+				removed++;
+				return elem;
+			}
+			/**
+			 * @brief Ƴʵ
+			 *
+			 * @param entitys IDʵ
+			 */
+			void EraseSorted(const std::vector<EntityID>& entitys)
+			{
+				std::erase_if(entity_map, [&](const auto& item)
+					{
+						return std::binary_search(entitys.begin(), entitys.end(), item.first);
+					});
+				Normalize();
+				size_t count = 0;
+				auto next = entitys.begin();
+				for (auto& row : rows)
+				{
+					while (next != entitys.end() && *next < row.first)
+					{
+						++next;
+					}
+					if (next == entitys.end() || *next != row.first)
+					{
+						rows[count++] = row;
+					}
+				}
+				rows.resize(count);
+				sorted = count;
+			}
+			/**
+			 * @brief ʵڵ
+			 *
+			 * @param entity ӵʵ
+			 * @return 
+			 */
+			std::pair<EntityID, void*>* FindRow(EntityID entity)
+			{
+				// 򲿷ֹʱ, ʹұֶʱ
+				if (rows.size() - sorted > 32)
+				{
+					Normalize();
+				}
+				auto end = rows.begin() + sorted;
+				auto it = std::lower_bound(rows.begin(), end, entity, [](const auto& row, EntityID id)
+					{
+						return row.first < id;
+					});
+				if (it == end || it->first != entity || !it->second)
+				{
+					it = std::find_if(end, rows.end(), [entity](const auto& row)
+						{
+							return row.first == entity && row.second;
+						});
+				}
+				assertm(it != rows.end(), "ʵûи");
+				return &*it;
+			}
+			/**
+			 * @brief ʵID˳еʵ
+			 *
+			 * ˳ֻӵʵ弯Ͼ, ʵƳȺ޹
+			 */
+			const std::vector<std::pair<EntityID, void*>>& Rows()
+			{
+				Normalize();
+				return rows;
+			}
+			/**
+			 * @brief ѹƳ, ¼й鲢򲿷
+			 */
+			void Normalize()
+			{
+				if (removed > 0)
+				{
+					size_t count = 0;
+					size_t kept = 0;
+					for (size_t i = 0; i < rows.size(); i++)
+					{
+						if (rows[i].second)
+						{
+							kept += i < sorted;
+							rows[count++] = rows[i];
+						}
+					}
+					rows.resize(count);
+					sorted = kept;
+					removed = 0;
+				}
+				if (sorted < rows.size())
+				{
+					auto less = [](const auto& a, const auto& b)
+					{
+						return a.first < b.first;
+					};
+					auto middle = rows.begin() + sorted;
+					std::sort(middle, rows.end(), less);
+					std::inplace_merge(rows.begin(), middle, rows.end(), less);
+					sorted = rows.size();
+				}
+			}
+		};
+		/**
+		 * @brief Ԥһ
+		 */
+		struct PrefabColumn
+		{
+			ComponentID index;		///< 
+			ComponentInfo* info;	///< Ŀ
+			void* value;			///< Ĭֵ
+		};
+		/**
+		 * @brief Ԥɼƻ
+		 */
+		struct PrefabPlan
+		{
+			std::vector<PrefabColumn> columns;	///< Ԥ
+			PrefabPlan() = default;
+			PrefabPlan(const PrefabPlan&) = delete;
+			PrefabPlan& operator = (const PrefabPlan&) = delete;
+			~PrefabPlan()
+			{
+				for (auto& column : columns)
+				{
+					column.info->ops->destory(column.value);
+				}
+			}
+		};
+		/**
+		 * @brief ϵͳʼ
+		 */
+		struct SystemAccess
+		{
+			std::vector<ComponentID> reads;		///< ֻʵ
+			std::vector<ComponentID> writes;	///< дʵ
+		};
+		/**
+		 * @brief ϵͳϢ
+		 */
+		struct UpdateSystemInfo
+		{
+			using Tick = ChangeTick::Tick;
+			std::function<void(UpdateSystemInfo&)> bind;	///< ɲ״̬, ʼ
+			std::function<void(Command&, Event&)> run;	///< עϵͳ, ״̬ͷźΪ
+			SystemAccess access;	///< ϵͳʼ
+			std::vector<std::function<bool(Tick)>> conditions;	///< , Ϊϵͳϴеʱ
+			Tick last_run = 0;		///< ϵͳϴнʱʱ
+			/**
+			 * @brief ͷŲ״̬, ֱ֮ٴ bind ǰϵͳ
+			 */
+			void Release()
+			{
+				run = nullptr;
+				access = {};
+				conditions.clear();
+				last_run = 0;
+			}
+			/**
+			 * @brief ֡ǷҪϵͳ
+			 */
+			bool ShouldRun()const
+			{
+				if (!run)
+				{
+					return false;
+				}
+				for (auto& condition : conditions)
+				{
+					if (!condition(last_run))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+		};
+		/**
+		 * @brief ЭϵͳϢ
+		 */
+		struct TaskInfo
+		{
+			std::function<Task(TaskContext&)> sys;	///< Э
+			TaskContext context;	///< Э
+			Task task;				///< еЭ
+			int start_frame = 0;	///< ڸ֡һЭ
+			template<typename F>
+			TaskInfo(Sence& sence, F&& func) :sys(std::forward<F>(func)), context(sence)
+			{}
+		};
+		/**
+		 * @brief еĿ, ֵ
+		 */
+		struct ColumnSnapshot
+		{
+			using Tick = ChangeTick::Tick;
+			const ComponentOps* ops = nullptr;	///< 
+			Tick state = 0;			///< ʱݱʶ
+			Tick structure = 0;		///< ʱʵ弯ʱ
+			std::vector<EntityID> entitys;	///< ʵIDеʵ
+			void* values = nullptr;	///< ʵһһӦֵ
+			ColumnSnapshot() = default;
+			ColumnSnapshot(const ColumnSnapshot&) = delete;
+			ColumnSnapshot& operator = (const ColumnSnapshot&) = delete;
+			~ColumnSnapshot()
+			{
+				if (values)
+				{
+					ops->destory_array(values);
+				}
+			}
+		};
+		/**
+		 * @brief ˳Ŀ
+		 */
+		struct GroupSnapshot
+		{
+			ChangeTick::Tick order = 0;		///< ʱ˳ʶ
+			std::vector<EntityID> entitys;	///< ˳еʵ
+		};
+		/**
+		 * @brief Դ
+		 */
+		struct ResourceTrack
+		{
+			ComponentID index;		///< Դ
+			destoryFunc destory;	///< 
+			void* (*clone)(const void*);		///< Դ
+			void (*assign)(void*, const void*);	///< յֵԴ
+		};
+		/**
+		 * @brief һ֡ļ
+		 */
+		struct Checkpoint
+		{
+			int frame = 0;			///< ֡
+			EntityID next_entity = 0;	///< һʵID
+			std::unordered_map<ComponentID, std::shared_ptr<const ColumnSnapshot>> columns;	///< еĿ
+			std::unordered_map<int, std::shared_ptr<const GroupSnapshot>> groups;	///< ˳
+			std::vector<std::shared_ptr<const void>> resources;	///< ԴһһӦ, ԴδʱΪ
+		};
+		/**
+		 * @brief Ļ, ͳһвͬ͵
+		 */
+		struct GroupBase
+		{
+			virtual ~GroupBase() = default;
+			/**
+			 * @brief ʵ
+			 */
+			virtual size_t Size()const = 0;
+			/**
+			 * @brief Ƿ
+			 */
+			virtual bool Covers(ComponentID index)const = 0;
+			/**
+			 * @brief ʵǷ
+			 */
+			virtual bool Contains(EntityID entity)const = 0;
+			/**
+			 * @brief ˳гʵ弰һ
+			 *
+			 * @param index 
+			 * @param rows ʵ
+			 */
+			virtual void CollectRows(ComponentID index, std::vector<std::pair<EntityID, void*>>& rows)const = 0;
+			/**
+			 * @brief ˳ıʶ, еɾ򶼻ı
+			 */
+			virtual ChangeTick::Tick Order()const = 0;
+			/**
+			 * @brief ˳гʵ
+			 *
+			 * @param entitys ʵ
+			 */
+			virtual void SaveOrder(std::vector<EntityID>& entitys)const = 0;
+			/**
+			 * @brief ʵ˳Ÿ, δʵ
+			 *
+			 * @param entitys ʵ˳
+			 * @param order ʱ˳ʶ
+			 */
+			virtual void RestoreOrder(const std::vector<EntityID>& entitys, ChangeTick::Tick order) = 0;
+		};
+		/**
+		 * @brief ֶνе
+		 *
+		 * ƶڼԭжڶصĿö, ᱻٴη, ƶͳһ޳
+		 */
+		struct CompactPass
+		{
+			ComponentID index = 0;		///< 
+			ChangeTick::Tick structure = 0;	///< ʼʱʵ弯ϱʶ
+			std::vector<EntityID> entitys;	///< ˳еʵ
+			std::vector<void*> moved;		///< ڴ
+			std::vector<void*> released;	///< ͷŵԭжж
+			std::vector<std::pair<char*, char*>> dead_blocks;	///< ͷŵľڴ
+			std::vector<std::pair<char*, char*>> owned_blocks;	///< ַȫڴ, ڶͷ
+			size_t old_blocks = 0;		///< ʼʱеڴ, λڿбǰ
+			size_t cursor = 0;			///< һƶʵ
+			size_t release_cursor = 0;	///< һͷŵĶ
+			bool finished = false;		///< Ƿȫƶ
+			bool changed = false;		///< ڼʵ弯Ƿ仯
+		};
+		/**
+		 * @brief ֶνеݴ粢
+		 */
+		struct MergePass
+		{
+			EntityID base = 0;		///< ݴռõĳʵID
+			EntityID cursor = 0;	///< һݴʵID
+			std::vector<std::pair<ComponentInfo*, ComponentInfo*>> columns;	///< Ӧݴ
+			std::vector<size_t> rows;	///< ݴһ
 		};
 		/**
 		 * @brief Դ, Դڹ
@@ -141,6 +827,7 @@ namespace TanmiEngine {
 		{
 			void* resource = nullptr;
 			destoryFunc destory;
+			ChangeTick::Tick version = 0;	///< Դһ, Ƴ޸ĵʱ
 			ResourceInfo() = default;
 			ResourceInfo(destoryFunc des) :destory(des)
 			{
@@ -174,502 +861,3038 @@ namespace TanmiEngine {
 		ResouceMap _resources;	///< Դ
 
 		std::vector<StartupSystem> _startupSystems;	///< õϵͳб
-		std::vector<UpdateSystem> _updateSystems;	///< µϵͳб
+		std::vector<UpdateSystemInfo> _updateSystems;	///< µϵͳб
+		std::vector<std::unique_ptr<TaskInfo>> _tasks;	///< Эϵͳб
+		size_t _task_cursor = 0;	///< һ֡ȻָЭϵͳ
+		std::chrono::microseconds _task_budget{ 2000 };	///< ÿָ֡ЭϵͳʱԤ
+		std::chrono::microseconds _defrag_budget{ 0 };	///< ÿ֡洢ʱԤ
+		size_t _defrag_cursor = 0;	///< ´ʱȼ
+		std::unique_ptr<CompactPass> _compact;	///< ڽе
 		std::vector<std::unique_ptr<Plugin>> _plugin_list;	///< б
+		std::vector<std::unique_ptr<PrefabPlan>> _prefabs;	///< Ԥб
 		EventSystem* _eventSystem = nullptr;	///< ¼ϵͳ
-	};
-	/**
-	 * @brief Դ, Դ
-	 */
-	class Resource final
-	{
-	public:
-		Resource() = delete;
-		Resource(Sence& sence) :_sence(sence)
-		{}
+		std::unordered_map<int, std::unique_ptr<GroupBase>> _groups;	///< 
+		std::unordered_map<int, std::shared_ptr<void>> _shared;	///< ȥر
+		std::mutex _shared_mutex;		///< ȥر
+		std::vector<StagingWorld> _staging;	///< ݴ
+		std::mutex _staging_mutex;		///< ݴύ
+		std::vector<StagingWorld> _merging;	///< еݴ, ׸Ѳֲ
+		std::unique_ptr<MergePass> _merge;	///< ׸ݴĲ
+		std::chrono::microseconds _merge_budget{ 0 };	///< ÿ֡ݴʱԤ
+		std::deque<Checkpoint> _checkpoints;	///< ļ
+		std::vector<ResourceTrack> _resource_tracks;	///< Դ
+		size_t _checkpoint_depth = 8;	///< ļ
+		int _frame = 0;		///< ǰ֡
+		EntityID _next_entity = 0;	///< һʵID, ÿ䲢ָ
+	private:
+		/**
+		 * @brief ȡ, ʱ
+		 *
+		 * @tparam T 
+		 * @return 
+		 */
 		template<typename T>
-		bool Has()const
-		{
-			auto index = IndexGenerator::Get<T>();
-			auto it = _sence._resources.find(index);
-			return it != _sence._resources.end() && it->second.resource != nullptr;
-		}
-		template<typename T>
-		T& Get()
+		ComponentInfo& GetComponentInfo();
+		/**
+		 * @brief µʵID
+		 */
+		EntityID NewEntity()
 		{
-			int index = IndexGenerator::Get<T>();
-			assertm("resource is empty", _sence._resources[index].resource);
-			return *static_cast<T*>(_sence._resources[index].resource);
+			return _next_entity++;
 		}
-	private:
-		Sence& _sence;
-	};
-
-	class Command final
-	{
-	public:
-		Command() = delete;
-		Command(Sence& sence) :_sence(sence)
-		{}
 		/**
-		 * @brief һһʵ
+		 * @brief ʵȫüص
 		 *
-		 * @param 
-		 * @return 
+		 * @param entity ʵ
+		 * @param container ʵ
 		 */
-		template<typename ... ComponentTypes>
-		Command& Spawn(ComponentTypes&& ... components)
-		{
-			SpawnAndGet<ComponentTypes ...>(std::forward<ComponentTypes>(components)...);
-			return *this;
-		}
+		void NotifyAdd(EntityID entity, const ComponentContainer& container);
 		/**
-		 * @brief һһʵ岢
+		 * @brief Ԥһ
 		 *
-		 * @param 
-		 * @return ʵID
+		 * @tparam T 
+		 * @param component Ĭֵ
+		 * @return 
 		 */
-		template<typename ... ComponentTypes>
-		EntityID SpawnAndGet(ComponentTypes&& ... components)
-		{
-			EntitySpawnInfo info;
-			info.id = IDGenerator<EntityID>::GetID();
-			AddComponent<ComponentTypes ...>(info.components, std::forward<ComponentTypes>(components)...);
-			_spawn_entitys.push_back(info);
-			return info.id;
-		}
+		template<typename T, typename U>
+		PrefabColumn MakePrefabColumn(U&& component);
 		/**
-		 * @brief ɾһʵ
+		 * @brief Ϊϵͳÿע״̬, װΪͳһĵʽ
 		 *
-		 * @param id ʵID
-		 * @return 
+		 * @param sys ϵͳ
+		 * @param access ¼ϵͳʼ
+		 * @return עϵͳĺ
 		 */
-		Command& Destroy(EntityID id)
-		{
-			_destroy_entitys.push_back(id);
-			return *this;
-		}
+		template<typename F, typename ...Params>
+		std::function<void(Command&, Event&)> MakeUpdateSystem(const F& sys, SystemAccess& access, std::tuple<Params...>*);
 		/**
-		 * @brief һԴ
+		 * @brief ״̬, װΪͳһֵʽ
 		 *
-		 * @param resource Դ
-		 * @return 
+		 * @param condition 
+		 * @param access ϵͳʼ
+		 * @return ֵ, Ϊϵͳϴеʱ
 		 */
-		template<typename T>
-		Command& SetResource(T&& resource)
+		template<typename C>
+		std::function<bool(ChangeTick::Tick)> MakeRunCondition(const C& condition, const SystemAccess& access);
+		/**
+		 * @brief ʱԤָЭϵͳ, ٻָһ; ĳЭ׳쳣ʱ֡ٻָЭ
+		 *
+		 * @param cmd ֡Э̵
+		 * @param event ֡¼
+		 * @return Э׳쳣,  Update ڱ֡׳
+		 */
+		std::exception_ptr RunTasks(Command& cmd, Event& event);
+		/**
+		 * @brief ͳеƬ
+		 *
+		 * ʱ˳ͳ, ڵʵʵID˳ͳ
+		 *
+		 * @param index 
+		 * @param info 
+		 * @param entitys ǿʱͳ˳¼ʵ, ʹ, ȥٴα
+		 * @return Ƭͳ
+		 */
+		StorageStats MeasureColumn(ComponentID index, ComponentInfo& info, std::vector<EntityID>* entitys = nullptr)const;
+		/**
+		 * @brief ȡвֵ, ڶʱȡʵ
+		 *
+		 * @param index 
+		 * @return , κʱΪ
+		 */
+		const GroupBase* LayoutGroup(ComponentID index)const;
+		/**
+		 * @brief ʼ, ӹܶصĿж
+		 *
+		 * @param index 
+		 * @param info 
+		 * @param entitys ˳еʵ
+		 */
+		void BeginCompact(ComponentID index, ComponentInfo& info, std::vector<EntityID>&& entitys);
+		/**
+		 * @brief ƽе: ͳƬʱ˳ֶνڴ, ֶ֮ͷԭжж
+		 *
+		 * @param info 
+		 * @param deadline ֹʱ, ƽһ
+		 * @return Ƿ
+		 */
+		bool StepCompact(ComponentInfo& info, TaskClock::time_point deadline);
+		/**
+		 * @brief ȫƶ, ؽصĿö, ҳľڴ
+		 *
+		 * @param info 
+		 */
+		void FinishCompactMove(ComponentInfo& info);
+		/**
+		 * @brief Ҷڵڴ
+		 *
+		 * @param blocks ַڴ
+		 * @param elem 
+		 * @return ڴ, κοʱΪ blocks.end()
+		 */
+		static std::vector<std::pair<char*, char*>>::const_iterator FindBlock(
+			const std::vector<std::pair<char*, char*>>& blocks, void* elem);
+		/**
+		 * @brief ύݴ粢볡
+		 *
+		 * @param deadline ֹʱ, ƽһ
+		 * @return Ƿȫ
+		 */
+		bool MergeStaging(TaskClock::time_point deadline);
+		/**
+		 * @brief ʼ׸ݴ: һĳʵID, ӹݴ
+		 */
+		void BeginMerge();
+		/**
+		 * @brief ƽ׸ݴĲ, ÿβһʵȫ, ɺƳб
+		 *
+		 * @param deadline ֹʱ, ƽһ
+		 * @return Ƿ
+		 */
+		bool StepMerge(TaskClock::time_point deadline);
+		/**
+		 * @brief еĲ, δ
+		 */
+		void AbortMerge();
+		/**
+		 * @brief еĿ
+		 *
+		 * @param info 
+		 * @return 
+		 */
+		std::shared_ptr<const ColumnSnapshot> CaptureColumn(ComponentInfo& info);
+		/**
+		 * @brief лָΪ, ֻʵɾ첿, ʵԭظֵ
+		 *
+		 * նʵID, һ˳鲢ҳ
+		 *
+		 * @param index 
+		 * @param info 
+		 * @param snapshot , Ϊձʾʱв
+		 * @param added ָʱ¼, ȫлָüص
+		 */
+		void RestoreColumn(ComponentID index, ComponentInfo& info, const ColumnSnapshot* snapshot,
+			std::vector<std::tuple<ComponentInfo*, EntityID, void*>>& added);
+	};
+	/**
+	 * @brief Ԥ,  Sence::MakePrefab ע, ͨ Command::Spawn ʵ
+	 */
+	class Prefab final
+	{
+	public:
+		friend class Sence;
+		friend class Command;
+		friend class StagingWorld;
+		Prefab() = default;
+		/**
+		 * @brief Ԥ, ʹֱ֮ӸƵѷĶ
+		 *
+		 * @param count Ԥʵ
+		 */
+		void Reserve(size_t count)const
 		{
-			auto index = IndexGenerator::Get<T>();
-			if (auto it = _sence._resources.find(index);
-				it == _sence._resources.end())
-			{
-				auto res = _sence._resources.emplace(index, Sence::ResourceInfo(
-					[](void* elem)
-					{
-						delete (T*)elem;
-					}
-				));
-				res.first->second.resource = new T(std::move(std::forward<T>(resource)));
-			}
-			else
+			assertm(_plan, "ԤΪ");
+			for (auto& column : _plan->columns)
 			{
-				assertm(it->second.resource, "ԴѴ");
-				it->second.resource = new T(std::move(std::forward<T>(resource)));
+				column.info->pool.reserve(count);
+				column.info->entity_map.reserve(column.info->entity_map.size() + count);
 			}
-			return *this;
-		}
-		template<typename T>
-		Command& RemoveResource()
-		{
-			auto index = IndexGenerator::Get<T>();
-			_destory_resource.emplace_back(index, [](void* elem)
-				{
-					delete (T*)elem;
-				});
-			return *this;
 		}
 		/**
-		 * @brief ɳ༭
+		 * @brief ԤǷЧ
 		 */
-		void Execute()
+		explicit operator bool()const
 		{
-			for (auto& entity : _destroy_entitys)
-			{
-				DestoryEntity(entity);
-			}
-			for (auto& resource : _destory_resource)
-			{
-				removeResource(resource);
-			}
-			for (auto& entitys : _spawn_entitys)
+			return _plan != nullptr;
+		}
+	private:
+		Prefab(const Sence::PrefabPlan* plan) :_plan(plan)
+		{}
+		const Sence::PrefabPlan* _plan = nullptr;	///< ɼƻ
+	};
+	/**
+	 * @brief ݴ, ӵж洢, ں̨߳ͨ Sence::Splice 볡
+	 *
+	 * һݴͬһʱֻһ߳; Spawn صݴڵʵID, 0ʼ,
+	 * ʱݴռһĳʵID, ʵIDΪöεݴʵID
+	 */
+	class StagingWorld final
+	{
+	public:
+		friend class Sence;
+		StagingWorld() = default;
+		StagingWorld(const StagingWorld&) = delete;
+		StagingWorld& operator = (const StagingWorld&) = delete;
+		StagingWorld(StagingWorld&&) = default;
+		StagingWorld& operator = (StagingWorld&&) = default;
+		~StagingWorld()
+		{
+			for (auto& [index, info] : _components)
 			{
-				auto it =
-					_sence._entitys.emplace(entitys.id, Sence::ComponentContainer{});
-				auto& container = it.first->second;
-				for (auto& componentInfo : entitys.components)
+				for (auto elem : info.pool.instances)
 				{
-					container[componentInfo.index] = AddComponentToSence(entitys.id, componentInfo);
+					info.ops->destory(elem);
+				}
+				for (auto elem : info.pool.cache)
+				{
+					info.ops->destory(elem);
 				}
 			}
 		}
-	private:
-		struct ComponentSpawnInfo;
 		/**
-		 * @brief Ϊʵ
+		 * @brief һһʵ
 		 *
-		 * @param component_spawn_info Ϣ
-		 * @param component	
-		 * @param ...remains ʣ
+		 * @param components 
+		 * @return ݴڵʵID
 		 */
-		template<typename T, typename ... Remains>
-		void AddComponent(std::vector<ComponentSpawnInfo>& component_spawn_info, T&& component, Remains ... remains)
+		template<typename ...ComponentTypes>
+			requires (!std::is_same_v<std::decay_t<ComponentTypes>, Prefab> && ...)
+		EntityID Spawn(ComponentTypes&& ...components)
 		{
-			ComponentSpawnInfo info;
-			info.index = IndexGenerator::Get<T>();
-			info.assign = [=](void* elem)
-			{
-				*static_cast<T*>(elem) = component;
-			};
-			info.create = []() -> void*
-			{
-				return new T();
-			};
-			info.destory = [](void* elem)
-			{
-				delete static_cast<T*>(elem);
-			};
-			component_spawn_info.push_back(info);
-			if constexpr (sizeof ...(Remains) != 0)
-			{
-				AddComponent<Remains ...>(component_spawn_info, std::forward<Remains>(remains)...);
-			}
+			EntityID entity = static_cast<EntityID>(_entitys.size());
+			auto& container = _entitys.emplace_back();
+			(AddComponent<std::decay_t<ComponentTypes>>(entity, container, std::forward<ComponentTypes>(components)), ...);
+			return entity;
 		}
 		/**
-		 * @brief Ϊʵɳɲ
+		 * @brief Ԥһʵ
 		 *
-		 * @param entity ʵid
-		 * @param info Ϣ
-		 * @return 
+		 * @param prefab Ԥ
+		 * @param overrides Ĭֵ׷ӵ
+		 * @return ݴڵʵID
 		 */
-		void* AddComponentToSence(EntityID entity, ComponentSpawnInfo& info)
+		template<typename ...Overrides>
+		EntityID Spawn(const Prefab& prefab, Overrides&& ...overrides)
 		{
-			if (auto it = _sence._components.find(info.index);
-				it == _sence._components.end())
+			assertm(prefab._plan, "ԤΪ");
+			EntityID entity = static_cast<EntityID>(_entitys.size());
+			auto& container = _entitys.emplace_back();
+			for (auto& column : prefab._plan->columns)
 			{
-				_sence._components.emplace(info.index,
-					Sence::ComponentInfo(info.create, info.destory));
+				auto& info = GetColumn(column.index, column.info->ops);
+				void* elem = info.pool.create();
+				info.ops->copy(elem, column.value);
+				info.rows.emplace_back(entity, elem);
+				container[column.index] = elem;
 			}
-			auto& componentInfo = _sence._components[info.index];
-			void* elem = componentInfo.pool.create();
-			info.assign(elem);
-			componentInfo.entity_map[entity] = elem;
-			return elem;
+			(AddComponent<std::decay_t<Overrides>>(entity, container, std::forward<Overrides>(overrides)), ...);
+			return entity;
 		}
 		/**
-		 * @brief ӳɾʵ
-		 *
-		 * @param entity ʵ
+		 * @brief ݴʵ
 		 */
-		void DestoryEntity(EntityID entity)
+		size_t Size()const
 		{
-			if (auto it = _sence._entitys.find(entity);
-				it != _sence._entitys.end())
+			return _entitys.size();
+		}
+	private:
+		Sence::ComponentInfo& GetColumn(ComponentID index, const ComponentOps* ops)
+		{
+			if (auto it = _components.find(index);
+				it != _components.end())
 			{
-				for (auto& [id, component] : it->second)
-				{
-					auto& componentInfo = _sence._components[id];
-					componentInfo.pool.destory(component);
-					componentInfo.entity_map.erase(id);
-				}
+				return it->second;
 			}
+			return _components.emplace(index, Sence::ComponentInfo(ops)).first->second;
 		}
-		/**
-		 * @brief  ӳƳԴ
-		 *
-		 * @param info ԴϢ
-		 */
-		struct ResourceDestoryInfo;
-		void removeResource(ResourceDestoryInfo& info)
+		template<typename T, typename U>
+		void AddComponent(EntityID entity, Sence::ComponentContainer& container, U&& component)
 		{
-			if (auto it = _sence._resources.find(info._index);
-				it != _sence._resources.end())
+			auto index = IndexGenerator::Get<T>();
+			if (auto it = container.find(index);
+				it != container.end())
 			{
-				info._destory(it->second.resource);
-				it->second.resource = nullptr;
+				*static_cast<T*>(it->second) = std::forward<U>(component);
+				return;
 			}
+			auto& info = GetColumn(index, ComponentOps::Get<T>());
+			void* elem = info.pool.create();
+			*static_cast<T*>(elem) = std::forward<U>(component);
+			info.rows.emplace_back(entity, elem);
+			container[index] = elem;
 		}
 	private:
-		using AssignFunc = std::function<void(void*)>;
-		/**
-		 * @brief Ϣ
-		 */
-		struct ComponentSpawnInfo
+		Sence::ComponentMap _components;	///< ݴ, ֻʹðݴʵIDе rows
+		std::vector<Sence::ComponentContainer> _entitys;	///< ݴʵ, ±ΪݴʵID
+	};
+	/**
+	 * @brief ȥطʽ, Ĭʹ std::hash  ==, ػ
+	 */
+	template<typename T>
+	struct SharedTraits
+	{
+		static size_t Hash(const T& value)
 		{
-			AssignFunc assign;	///< ֵ
-			createFunc create;	///< 
-			destoryFunc destory;	///< ٺ
-			ComponentID index;	///< 
-		};
+			return std::hash<T>{}(value);
+		}
+		static bool Equal(const T& a, const T& b)
+		{
+			return a == b;
+		}
+	};
+	/**
+	 * @brief , ȥغֻ,  Sence::Share  Command::Share ȡ
+	 *
+	 * ֵͬĹָͬһ, ˿ֱӱȽǷ; ޸ʱȡµĹ滻
+	 *
+	 * @tparam T 
+	 */
+	template<typename T>
+	class Shared final
+	{
+	public:
+		template<typename U>
+		friend class SharedStore;
+		Shared() = default;
+		const T& operator*()const
+		{
+			assertm(_value, "Ϊ");
+			return *_value;
+		}
+		const T* operator->()const
+		{
+			assertm(_value, "Ϊ");
+			return _value.get();
+		}
+		const T* Get()const
+		{
+			return _value.get();
+		}
+		explicit operator bool()const
+		{
+			return _value != nullptr;
+		}
 		/**
-		 * @brief ʵϢ
+		 * @brief ͬһݵĹ
 		 */
-		struct EntitySpawnInfo
+		long UseCount()const
 		{
-			std::vector<ComponentSpawnInfo> components;	///< ʵӵе
-			EntityID id;	///< ʵID
-		};
+			return _value.use_count();
+		}
 		/**
-		 * @brief ݻԴ
+		 * @brief ͷ
 		 */
-		struct ResourceDestoryInfo
+		void Reset()
 		{
-			int _index;	///< 
-			destoryFunc _destory;  ///< 
-			ResourceDestoryInfo(int index, destoryFunc destory) :_index(index), _destory(destory)
-			{}
-		};
+			_value.reset();
+		}
+		bool operator == (const Shared& other)const
+		{
+			return _value == other._value;
+		}
 	private:
-		Sence& _sence;	///< 󳡾
-		std::vector<EntitySpawnInfo> _spawn_entitys;	///< ɵʵ
-		std::vector<EntityID> _destroy_entitys;	///< ٵʵ
-		std::vector<ResourceDestoryInfo> _destory_resource; ///< ٵԴ
+		explicit Shared(std::shared_ptr<const T> value) :_value(std::move(value))
+		{}
+		std::shared_ptr<const T> _value;
 	};
 	/**
-	 * @brief ѯ
+	 * @brief յʱͷ, ʹõݼʱͷ
 	 */
-	class Queryer
+	template<typename T>
+	struct PoolRecycle<Shared<T>>
 	{
-	public:
-		Queryer() = delete;
-		Queryer(Sence& _sence) :sence(_sence)
-		{}
-		~Queryer() = default;
+		static constexpr destoryFunc func = [](void* elem)
+		{
+			static_cast<Shared<T>*>(elem)->Reset();
+		};
+	};
+	/**
+	 * @brief һ๲ȥر, ֻݵ, ͷʱӱƳ
+	 *
+	 * @tparam T 
+	 */
+	template<typename T>
+	class SharedStore final : public std::enable_shared_from_this<SharedStore<T>>
+	{
+	public:
 		/**
-		 * @brief ȡָʵ
+		 * @brief ȡֵͬĹ, ʱ
+		 */
+		template<typename U>
+		Shared<T> Intern(U&& value)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _values.find(&value);
+			if (it != _values.end())
+			{
+				if (auto shared = it->second.lock())
+				{
+					return Shared<T>(std::move(shared));
+				}
+				_values.erase(it);
+			}
+			std::weak_ptr<SharedStore> store = this->weak_from_this();
+			std::shared_ptr<const T> shared(new T(std::forward<U>(value)), [store](const T* elem)
+				{
+					if (auto owner = store.lock())
+					{
+						owner->Release(elem);
+					}
+					delete elem;
+				});
+			_values.emplace(shared.get(), shared);
+			return Shared<T>(std::move(shared));
+		}
+		/**
+		 * @brief ǰֵͬ
+		 */
+		size_t Size()
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _values.size();
+		}
+	private:
+		void Release(const T* elem)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (auto it = _values.find(elem);
+				it != _values.end() && it->first == elem)
+			{
+				_values.erase(it);
+			}
+		}
+		struct ValueHash
+		{
+			size_t operator()(const T* value)const
+			{
+				return SharedTraits<T>::Hash(*value);
+			}
+		};
+		struct ValueEqual
+		{
+			bool operator()(const T* a, const T* b)const
+			{
+				return SharedTraits<T>::Equal(*a, *b);
+			}
+		};
+		std::unordered_map<const T*, std::weak_ptr<const T>, ValueHash, ValueEqual> _values;	///< ݵ
+		std::mutex _mutex;	///< ݿ߳ͷ
+	};
+	/**
+	 * @brief Դ, Դ
+	 */
+	class Resource final
+	{
+	public:
+		Resource() = delete;
+		Resource(Sence& sence) :_sence(sence)
+		{}
+		template<typename T>
+		bool Has()const
+		{
+			auto index = IndexGenerator::Get<T>();
+			auto it = _sence._resources.find(index);
+			return it != _sence._resources.end() && it->second.resource != nullptr;
+		}
+		/**
+		 * @brief ȡԴ, ¼޸; Ҫ ResourceChanged ֪޸ʱ MarkChanged
+		 */
+		template<typename T>
+		T& Get()
+		{
+			int index = IndexGenerator::Get<T>();
+			auto& info = _sence._resources[index];
+			assertm(info.resource, "resource is empty");
+			return *static_cast<T*>(info.resource);
+		}
+		/**
+		 * @brief Դ޸, ʹ ResourceChanged 
+		 */
+		template<typename T>
+		void MarkChanged()
+		{
+			if (auto it = _sence._resources.find(IndexGenerator::Get<T>());
+				it != _sence._resources.end() && it->second.resource)
+			{
+				it->second.version = ChangeTick::Next();
+			}
+		}
+		/**
+		 * @brief ֻȡԴ, Ϊ޸
+		 */
+		template<typename T>
+		const T& Get()const
+		{
+			auto it = _sence._resources.find(IndexGenerator::Get<T>());
+			assertm(it != _sence._resources.end() && it->second.resource, "resource is empty");
+			return *static_cast<const T*>(it->second.resource);
+		}
+	private:
+		Sence& _sence;
+	};
+
+	class Command final
+	{
+	public:
+		Command() = delete;
+		Command(Sence& sence) :_sence(sence)
+		{}
+		Command(const Command&) = delete;
+		Command& operator = (const Command&) = delete;
+		Command(Command&&) = default;
+		~Command()
+		{
+			// δִеͷŴд
+			for (auto& component : _spawn_components)
+			{
+				if (component.value)
+				{
+					component.ops->destory(component.value);
+				}
+			}
+		}
+		/**
+		 * @brief һһʵ
 		 *
-		 * @tparam Ҫѯ
-		 * @return ʵб
+		 * @param 
+		 * @return 
 		 */
-		template<typename ...Components>
-		std::vector<EntityID> GetEntitys()const
+		template<typename ... ComponentTypes>
+			requires (!std::is_same_v<std::decay_t<ComponentTypes>, Prefab> && ...)
+		Command& Spawn(ComponentTypes&& ... components)
 		{
-			std::vector<EntityID> entitys;
-			QueryEntitys<Components...>(entitys);
-			return entitys;
+			SpawnAndGet<ComponentTypes ...>(std::forward<ComponentTypes>(components)...);
+			return *this;
 		}
 		/**
-		 * @brief ѯʵǷӵض
+		 * @brief һһʵ岢
 		 *
-		 * @tparam Component 
-		 * @param entity ʵ
-		 * @return Ƿ
+		 * @param 
+		 * @return ʵID
 		 */
-		template<typename Component>
-		bool HasComponent(EntityID entity)const
+		template<typename ... ComponentTypes>
+			requires (!std::is_same_v<std::decay_t<ComponentTypes>, Prefab> && ...)
+		EntityID SpawnAndGet(ComponentTypes&& ... components)
 		{
-			auto it = sence._entitys.find(entity);
-			auto index = IndexGenerator::Get<Component>();
-			return(it != sence._entitys.end() && it->second.find(index) != it->second.end());
+			EntitySpawnInfo& info = _spawn_entitys.emplace_back();
+			info.id = _sence.NewEntity();
+			info.first = _spawn_components.size();
+			info.count = sizeof ...(ComponentTypes);
+			if constexpr (sizeof ...(ComponentTypes) != 0)
+			{
+				AddComponent(std::forward<ComponentTypes>(components)...);
+			}
+			return info.id;
+		}
+		/**
+		 * @brief Ԥһʵ
+		 *
+		 * @param prefab Ԥ
+		 * @param overrides Ĭֵ׷ӵ
+		 * @return 
+		 */
+		template<typename ... Overrides>
+		Command& Spawn(const Prefab& prefab, Overrides&& ... overrides)
+		{
+			SpawnAndGet<Overrides ...>(prefab, std::forward<Overrides>(overrides)...);
+			return *this;
+		}
+		/**
+		 * @brief Ԥһʵ岢
+		 *
+		 * @param prefab Ԥ
+		 * @param overrides Ĭֵ׷ӵ
+		 * @return ʵID
+		 */
+		template<typename ... Overrides>
+		EntityID SpawnAndGet(const Prefab& prefab, Overrides&& ... overrides)
+		{
+			assertm(prefab._plan, "ԤΪ");
+			EntitySpawnInfo& info = _spawn_entitys.emplace_back();
+			info.id = _sence.NewEntity();
+			info.prefab = prefab._plan;
+			info.first = _spawn_components.size();
+			info.count = sizeof ...(Overrides);
+			if constexpr (sizeof ...(Overrides) != 0)
+			{
+				AddComponent(std::forward<Overrides>(overrides)...);
+			}
+			return info.id;
+		}
+		/**
+		 * @brief ɾһʵ
+		 *
+		 * @param id ʵID
+		 * @return 
+		 */
+		Command& Destroy(EntityID id)
+		{
+			_destroy_entitys.push_back(id);
+			return *this;
+		}
+		/**
+		 * @brief ɾӵȫָʵ,  Execute ʱֵ
+		 *
+		 * @tparam Filter ɸѡ
+		 * @return 
+		 */
+		template<typename ...Filter>
+		Command& DespawnWhere()
+		{
+			static_assert(sizeof...(Filter) != 0, "ɸѡҪһ");
+			_despawn_filters.push_back([](Sence& sence, std::vector<EntityID>& entity_list)
+				{
+					auto entitys = Query<const Filter&...>(sence).GetEntitys();
+					entity_list.insert(entity_list.end(), entitys.begin(), entitys.end());
+				});
+			return *this;
+		}
+		/**
+		 * @brief ȡ, ʵ,  Sence::Share
+		 */
+		template<typename T>
+		Shared<std::decay_t<T>> Share(T&& value)
+		{
+			return _sence.Share(std::forward<T>(value));
+		}
+		/**
+		 * @brief һԴ
+		 *
+		 * @param resource Դ
+		 * @return 
+		 */
+		template<typename T>
+		Command& SetResource(T&& resource)
+		{
+			auto index = IndexGenerator::Get<T>();
+			if (auto it = _sence._resources.find(index);
+				it == _sence._resources.end())
+			{
+				auto res = _sence._resources.emplace(index, Sence::ResourceInfo(
+					[](void* elem)
+					{
+						delete (T*)elem;
+					}
+				));
+				res.first->second.resource = new T(std::move(std::forward<T>(resource)));
+				res.first->second.version = ChangeTick::Next();
+			}
+			else
+			{
+				assertm(it->second.resource, "ԴѴ");
+				it->second.resource = new T(std::move(std::forward<T>(resource)));
+				it->second.version = ChangeTick::Next();
+			}
+			return *this;
+		}
+		template<typename T>
+		Command& RemoveResource()
+		{
+			auto index = IndexGenerator::Get<T>();
+			_destory_resource.emplace_back(index, [](void* elem)
+				{
+					delete (T*)elem;
+				});
+			return *this;
+		}
+		/**
+		 * @brief ɳ༭
+		 */
+		void Execute()
+		{
+			DestoryEntitys();
+			for (auto& resource : _destory_resource)
+			{
+				removeResource(resource);
+			}
+			ReserveSpawn();
+			for (auto& entitys : _spawn_entitys)
+			{
+				auto it =
+					_sence._entitys.emplace(entitys.id, Sence::ComponentContainer{});
+				auto& container = it.first->second;
+				if (entitys.prefab)
+				{
+					AddPrefabToSence(entitys, container);
+				}
+				for (size_t i = entitys.first; i < entitys.first + entitys.count; i++)
+				{
+					auto& componentInfo = _spawn_components[i];
+					if (!componentInfo.value)
+					{
+						continue;
+					}
+					if (auto elem = container.find(componentInfo.index);
+						elem != container.end())
+					{
+						MoveComponent(elem->second, componentInfo);
+						continue;
+					}
+					container[componentInfo.index] = AddComponentToSence(entitys.id, componentInfo);
+				}
+				_sence.NotifyAdd(entitys.id, container);
+			}
+			_spawn_entitys.clear();
+			_spawn_components.clear();
+		}
+	private:
+		struct ComponentSpawnInfo;
+		struct EntitySpawnInfo;
+		/**
+		 * @brief Ϊʵ
+		 *
+		 * @param component	
+		 * @param ...remains ʣ
+		 */
+		template<typename T, typename ... Remains>
+		void AddComponent(T&& component, Remains&& ... remains)
+		{
+			using Type = std::decay_t<T>;
+			ComponentSpawnInfo& info = _spawn_components.emplace_back();
+			info.index = IndexGenerator::Get<Type>();
+			info.ops = ComponentOps::Get<Type>();
+			info.value = new Type(std::forward<T>(component));
+			if constexpr (sizeof ...(Remains) != 0)
+			{
+				AddComponent(std::forward<Remains>(remains)...);
+			}
+		}
+		/**
+		 * @brief д볡еͷ
+		 *
+		 * @param elem е
+		 * @param info Ϣ
+		 */
+		void MoveComponent(void* elem, ComponentSpawnInfo& info)
+		{
+			info.ops->move(elem, info.value);
+			info.ops->destory(info.value);
+			info.value = nullptr;
+		}
+		/**
+		 * @brief Ԥͳƴɵʵ, ΪÿһԤ
+		 */
+		void ReserveSpawn()
+		{
+			ReserveMore(_sence._entitys, _spawn_entitys.size());
+			std::vector<std::pair<const Sence::PrefabPlan*, size_t>> plans;
+			for (auto& entitys : _spawn_entitys)
+			{
+				if (!entitys.prefab)
+				{
+					continue;
+				}
+				auto it = std::find_if(plans.begin(), plans.end(), [&](auto& plan)
+					{
+						return plan.first == entitys.prefab;
+					});
+				if (it == plans.end())
+				{
+					plans.emplace_back(entitys.prefab, 1);
+				}
+				else
+				{
+					it->second++;
+				}
+			}
+			// ͬԤܹͬһ
+			std::vector<std::pair<Sence::ComponentInfo*, size_t>> columns;
+			for (auto& [plan, count] : plans)
+			{
+				for (auto& column : plan->columns)
+				{
+					auto it = std::find_if(columns.begin(), columns.end(), [&](auto& info)
+						{
+							return info.first == column.info;
+						});
+					if (it == columns.end())
+					{
+						columns.emplace_back(column.info, count);
+					}
+					else
+					{
+						it->second += count;
+					}
+				}
+			}
+			for (auto& [info, count] : columns)
+			{
+				info->Reserve(count);
+			}
+		}
+		/**
+		 * @brief Ϊʵɳɲ
+		 *
+		 * @param entity ʵid
+		 * @param info Ϣ
+		 * @return 
+		 */
+		void* AddComponentToSence(EntityID entity, ComponentSpawnInfo& info)
+		{
+			if (auto it = _sence._components.find(info.index);
+				it == _sence._components.end())
+			{
+				_sence._components.emplace(info.index, Sence::ComponentInfo(info.ops));
+			}
+			auto& componentInfo = _sence._components[info.index];
+			void* elem = info.value;
+			if (componentInfo.pool.cache.empty())
+			{
+				// дصĶ󴴽ʽͬ, ֱӽ
+				componentInfo.pool.adopt(elem);
+				info.value = nullptr;
+			}
+			else
+			{
+				elem = componentInfo.pool.create();
+				MoveComponent(elem, info);
+			}
+			componentInfo.Insert(entity, elem);
+			componentInfo.MarkStructure();
+			return elem;
+		}
+		/**
+		 * @brief ԤɼƻĬֱӸƵصĶ, ǵֱ븲ֵ
+		 *
+		 * @param info ʵϢ
+		 * @param container ʵ
+		 */
+		void AddPrefabToSence(EntitySpawnInfo& info, Sence::ComponentContainer& container)
+		{
+			auto& columns = info.prefab->columns;
+			auto first = _spawn_components.begin() + info.first;
+			auto last = first + info.count;
+			container.reserve(columns.size() + info.count);
+			for (auto& column : columns)
+			{
+				void* elem = column.info->pool.create();
+				if (auto value = std::find_if(first, last, [&](const ComponentSpawnInfo& component)
+					{
+						return component.index == column.index;
+					});
+					value != last)
+				{
+					MoveComponent(elem, *value);
+				}
+				else
+				{
+					column.info->ops->copy(elem, column.value);
+				}
+				column.info->Insert(info.id, elem);
+				column.info->MarkStructure();
+				container[column.index] = elem;
+			}
+		}
+		/**
+		 * @brief ӳɾдٵʵ
+		 *
+		 * ȰռյĶ, ٶÿеĶʵһ
+		 */
+		void DestoryEntitys()
+		{
+			for (auto collect : _despawn_filters)
+			{
+				collect(_sence, _destroy_entitys);
+			}
+			if (_destroy_entitys.empty())
+			{
+				return;
+			}
+			std::unordered_map<ComponentID, ComponentSweep> sweeps;
+			for (auto entity : _destroy_entitys)
+			{
+				auto it = _sence._entitys.find(entity);
+				if (it == _sence._entitys.end())
+				{
+					continue;
+				}
+				for (auto& [id, component] : it->second)
+				{
+					auto& sweep = sweeps[id];
+					if (!sweep.info)
+					{
+						sweep.info = &_sence._components[id];
+					}
+					for (auto& hook : sweep.info->on_remove)
+					{
+						hook(entity, component);
+					}
+					sweep.entitys.push_back(entity);
+					sweep.elems.push_back(component);
+				}
+				_sence._entitys.erase(it);
+			}
+			for (auto& [id, sweep] : sweeps)
+			{
+				if (sweep.entitys.size() * 8 < sweep.info->entity_map.size())
+				{
+					for (auto entity : sweep.entitys)
+					{
+						sweep.info->Erase(entity);
+					}
+				}
+				else
+				{
+					std::sort(sweep.entitys.begin(), sweep.entitys.end());
+					sweep.info->EraseSorted(sweep.entitys);
+				}
+				sweep.info->pool.destory(sweep.elems);
+				sweep.info->MarkStructure();
+			}
+		}
+		/**
+		 * @brief  ӳƳԴ
+		 *
+		 * @param info ԴϢ
+		 */
+		struct ResourceDestoryInfo;
+		void removeResource(ResourceDestoryInfo& info)
+		{
+			if (auto it = _sence._resources.find(info._index);
+				it != _sence._resources.end())
+			{
+				info._destory(it->second.resource);
+				it->second.resource = nullptr;
+				it->second.version = ChangeTick::Next();
+			}
+		}
+	private:
+		/**
+		 * @brief Ϣ
+		 */
+		struct ComponentSpawnInfo
+		{
+			void* value = nullptr;	///< д, д볡Ϊ
+			const ComponentOps* ops = nullptr;	///< 
+			ComponentID index;	///< 
+		};
+		/**
+		 * @brief ʵϢ
+		 */
+		struct EntitySpawnInfo
+		{
+			size_t first = 0;	///< ʵ _spawn_components еʼλ
+			size_t count = 0;	///< ʵ
+			const Sence::PrefabPlan* prefab = nullptr;	///< ʵԤ
+			EntityID id;	///< ʵID
+		};
+		/**
+		 * @brief һϢ
+		 */
+		struct ComponentSweep
+		{
+			Sence::ComponentInfo* info = nullptr;	///< 
+			std::vector<EntityID> entitys;	///< Ƴʵ
+			std::vector<void*> elems;		///< յ
+		};
+		/**
+		 * @brief ݻԴ
+		 */
+		struct ResourceDestoryInfo
+		{
+			int _index;	///< 
+			destoryFunc _destory;  ///< 
+			ResourceDestoryInfo(int index, destoryFunc destory) :_index(index), _destory(destory)
+			{}
+		};
+	private:
+		Sence& _sence;	///< 󳡾
+		std::vector<EntitySpawnInfo> _spawn_entitys;	///< ɵʵ
+		std::vector<ComponentSpawnInfo> _spawn_components;	///< ʵ, ʵδ
+		std::vector<EntityID> _destroy_entitys;	///< ٵʵ
+		std::vector<void(*)(Sence&, std::vector<EntityID>&)> _despawn_filters;	///< ֵ
+		std::vector<ResourceDestoryInfo> _destory_resource; ///< ٵԴ
+	};
+	/**
+	 * @brief ѯ
+	 */
+	class Queryer
+	{
+	public:
+		Queryer() = delete;
+		Queryer(Sence& _sence) :sence(_sence)
+		{}
+		~Queryer() = default;
+		/**
+		 * @brief ȡָʵ
+		 *
+		 * @tparam Ҫѯ
+		 * @return ʵб
+		 */
+		template<typename ...Components>
+		std::vector<EntityID> GetEntitys()const
+		{
+			std::vector<EntityID> entitys;
+			QueryEntitys<Components...>(entitys);
+			return entitys;
+		}
+		/**
+		 * @brief ѯʵǷӵض
+		 *
+		 * @tparam Component 
+		 * @param entity ʵ
+		 * @return Ƿ
+		 */
+		template<typename Component>
+		bool HasComponent(EntityID entity)const
+		{
+			auto it = sence._entitys.find(entity);
+			auto index = IndexGenerator::Get<Component>();
+			return(it != sence._entitys.end() && it->second.find(index) != it->second.end());
+		}
+		/**
+		 * @brief ȡʵӵе
+		 *
+		 * @tparam Component 
+		 * @param entity ʵ
+		 * @return 
+		 */
+		template<typename Component>
+		Component& GetComponent(EntityID entity)
+		{
+			auto index = IndexGenerator::Get<Component>();
+			assertm(sence._entitys[entity][index], "");
+			sence._components[index].MarkChanged();
+			return *((Component*)sence._entitys[entity][index]);
+		}
+		/**
+		 * @brief ֻȡʵӵе, 仯
+		 *
+		 * @tparam Component 
+		 * @param entity ʵ
+		 * @return 
+		 */
+		template<typename Component>
+		const Component& GetComponent(EntityID entity)const
+		{
+			auto index = IndexGenerator::Get<Component>();
+			auto& container = sence._entitys.at(entity);
+			assertm(container.find(index) != container.end(), "");
+			return *((const Component*)container.at(index));
+		}
+	private:
+		/**
+		 * @brief ʵ״βѯַ
+		 *
+		 * @tparam T ״
+		 * @tparam Remain ʣ
+		 * @param entity_list ѯʵб
+		 */
+		template<typename T, typename ...Remain>
+		void QueryEntitys(std::vector<EntityID>& entity_list)const
+		{
+			auto index = IndexGenerator::Get<T>();
+			Sence::ComponentInfo& info = sence._components[index];
+			for (auto& e : info.Rows())
+			{
+				if constexpr (sizeof...(Remain) != 0)
+				{
+					QueryEntitysRemain<Remain...>(e.first, entity_list);
+				}
+				else
+				{
+					entity_list.push_back(e.first);
+				}
+			}
+		}
+		/**
+		 * @brief Էϳνʵʣвѯ
+		 *
+		 * @tparam T 
+		 * @tparam Remain ʣ
+		 * @param entity_list ѯʵб
+		 */
+		template<typename T, typename ...Remain>
+		void QueryEntitysRemain(EntityID entity, std::vector<EntityID>& entity_list)const
+		{
+			auto index = IndexGenerator::Get<T>();
+			auto& container = sence._entitys[entity];
+			if (auto it = container.find(index);
+				it == container.end())
+			{
+				return;
+			}
+			if constexpr (sizeof...(Remain) != 0)
+			{
+				QueryEntitysRemain<Remain...>(entity, entity_list);
+			}
+			else
+			{
+				entity_list.push_back(entity);
+			}
+		}
+	private:
+		Sence& sence;
+	};
+	class EventSystem final
+	{
+	public:
+		friend class Sence;
+		friend class Event;
+		EventSystem() = delete;
+		EventSystem(Sence& sence) :_sence(sence)
+		{}
+		~EventSystem() = default;
+	private:
+		template<typename T>
+		void Send(T&& data)
+		{
+			EventMessage<T>::Set(std::forward<T>(data));
+			_update_list.push_back(EventMessage<T>::Update);
+		}
+		template<typename T>
+		void SendFuture(T&& data, float time)
+		{}
+		template<typename T>
+		bool Has()
+		{
+			return EventMessage<T>::Has();
+		}
+		template<typename T>
+		T& Get()
+		{
+			assertm(EventMessage<T>::Has(), "¼");
+			auto& msg = EventMessage<T>::Get().value();
+			return msg;
+		}
+		template<typename T>
+		void Clear()
+		{
+			EventMessage<T>::Clear();
+		}
+		template<typename T>
+		void Update()
+		{
+			EventMessage<T>::Update();
+		}
+		void UpdateList()
+		{
+			for (auto e : _update_list)
+			{
+				e();
+			}
+		}
+	private:
+		Sence& _sence;
+		using updateFunc = void(*)(void);
+		std::vector<updateFunc> _update_list;
+	};
+	class Event
+	{
+	public:
+		Event(EventSystem& event_system) :_event_system(event_system)
+		{}
+		template<typename T>
+		Event& Send(T&& data)
+		{
+			_event_system.Send(std::forward<T>(data));
+			return *this;
+		}
+		template<typename T>
+		Event& SendIns(T&& data)
+		{
+			_event_system.Send(std::forward<T>(data));
+			_event_system.Update<T>();
+			return *this;
+		}
+		template<typename T>
+		Event& SendFuture(T&& data, float time)
+		{}
+		template<typename T>
+		bool Has()
+		{
+			return _event_system.Has<T>();
+		}
+		template<typename T>
+		T& Get()
+		{
+			return _event_system.Get<T>();
+		}
+		template<typename T>
+		Event& Clear()
+		{
+			_event_system.Clear<T>();
+			return *this;
+		}
+
+	private:
+		EventSystem& _event_system;
+	};
+	/**
+	 * @brief ͻѯ, Ϊϵͳעʱ
+	 *
+	 * @tparam Components ,  Query<Position&, const Velocity&>, const ñʾֻ
+	 */
+	template<typename ...Components>
+	class Query final
+	{
+		static_assert(sizeof...(Components) != 0, "ѯҪһ");
+	public:
+		Query() = delete;
+		Query(Sence& sence) :_infos{ &sence.GetComponentInfo<std::remove_cvref_t<Components>>()... }
+		{}
+		/**
+		 * @brief ӵȫʵ
+		 *
+		 * @param func ص, Ϊ (Components...)  (EntityID, Components...)
+		 */
+		template<typename Func>
+		void Each(Func&& func)const
+		{
+			((std::is_const_v<std::remove_reference_t<Components>> ? void() :
+				_infos[IndexOf<Components>()]->MarkChanged()), ...);
+			size_t driver = Driver();
+			std::array<void*, sizeof...(Components)> elems;
+			for (auto& [entity, elem] : _infos[driver]->Rows())
+			{
+				if (Fetch(entity, driver, elem, elems))
+				{
+					Invoke(func, entity, elems, std::index_sequence_for<Components...>{});
+				}
+			}
+		}
+		/**
+		 * @brief ֵ, ͬһֵʵ, ڽÿֻһεĹᵽ
+		 *
+		 * ѯ Shared<T>, Ϊյʵ岻
+		 *
+		 * @tparam T 
+		 * @param group_func ÿ鿪ʼʱ, Ϊ (const T&)
+		 * @param func ÿʵ, ͬ Each
+		 */
+		template<typename T, typename GroupFunc, typename Func>
+		void EachShared(GroupFunc&& group_func, Func&& func)const
+		{
+			constexpr size_t shared = IndexOfType<Shared<T>>();
+			((std::is_const_v<std::remove_reference_t<Components>> ? void() :
+				_infos[IndexOf<Components>()]->MarkChanged()), ...);
+			using Elems = std::array<void*, sizeof...(Components)>;
+			std::vector<std::pair<EntityID, Elems>> rows;
+			std::vector<size_t> groups;
+			std::vector<const T*> values;
+			std::unordered_map<const T*, size_t> group_of;
+			size_t driver = Driver();
+			Elems elems;
+			for (auto& [entity, elem] : _infos[driver]->Rows())
+			{
+				if (!Fetch(entity, driver, elem, elems))
+				{
+					continue;
+				}
+				const T* value = static_cast<const Shared<T>*>(elems[shared])->Get();
+				if (!value)
+				{
+					continue;
+				}
+				auto [it, inserted] = group_of.emplace(value, values.size());
+				if (inserted)
+				{
+					values.push_back(value);
+				}
+				rows.emplace_back(entity, elems);
+				groups.push_back(it->second);
+			}
+			std::vector<size_t> offsets(values.size() + 1, 0);
+			for (auto group : groups)
+			{
+				offsets[group + 1]++;
+			}
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+			std::vector<size_t> order(rows.size());
+			std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < rows.size(); i++)
+			{
+				order[cursor[groups[i]]++] = i;
+			}
+			for (size_t group = 0; group < values.size(); group++)
+			{
+				group_func(*values[group]);
+				for (size_t i = offsets[group]; i < offsets[group + 1]; i++)
+				{
+					auto& row = rows[order[i]];
+					Invoke(func, row.first, row.second, std::index_sequence_for<Components...>{});
+				}
+			}
+		}
+		/**
+		 * @brief ȡӵȫʵ
+		 *
+		 * @return ʵб
+		 */
+		std::vector<EntityID> GetEntitys()const
+		{
+			std::vector<EntityID> entitys;
+			size_t driver = Driver();
+			std::array<void*, sizeof...(Components)> elems;
+			for (auto& [entity, elem] : _infos[driver]->Rows())
+			{
+				if (Fetch(entity, driver, elem, elems))
+				{
+					entitys.push_back(entity);
+				}
+			}
+			return entitys;
+		}
+		/**
+		 * @brief Ƿûӵȫʵ, ҵһƥʵ弴
+		 */
+		bool Empty()const
+		{
+			size_t driver = Driver();
+			std::array<void*, sizeof...(Components)> elems;
+			for (auto& [entity, elem] : _infos[driver]->Rows())
+			{
+				if (Fetch(entity, driver, elem, elems))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		/**
+		 * @brief ѯϵͳķʼ
+		 *
+		 * @param reads ֻ
+		 * @param writes д
+		 */
+		static void Access(std::vector<ComponentID>& reads, std::vector<ComponentID>& writes)
+		{
+			((std::is_const_v<std::remove_reference_t<Components>> ? reads : writes)
+				.push_back(IndexGenerator::Get<std::remove_cvref_t<Components>>()), ...);
+		}
+	private:
+		/**
+		 * @brief ڲѯе±
+		 */
+		template<typename C>
+		static constexpr size_t IndexOf()
+		{
+			constexpr bool match[] = { std::is_same_v<C, Components>... };
+			size_t index = 0;
+			while (!match[index])
+			{
+				index++;
+			}
+			return index;
+		}
+		/**
+		 * @brief ڲѯе±, const
+		 */
+		template<typename C>
+		static constexpr size_t IndexOfType()
+		{
+			constexpr bool match[] = { std::is_same_v<C, std::remove_cvref_t<Components>>... };
+			static_assert((std::is_same_v<C, std::remove_cvref_t<Components>> || ...), "ѯв");
+			size_t index = 0;
+			while (!match[index])
+			{
+				index++;
+			}
+			return index;
+		}
+		/**
+		 * @brief ѡʵٵ
+		 */
+		size_t Driver()const
+		{
+			size_t driver = 0;
+			for (size_t i = 1; i < _infos.size(); i++)
+			{
+				if (_infos[i]->entity_map.size() < _infos[driver]->entity_map.size())
+				{
+					driver = i;
+				}
+			}
+			return driver;
+		}
+		/**
+		 * @brief ȡʵȫ, ȱһʱfalse
+		 */
+		bool Fetch(EntityID entity, size_t driver, void* elem, std::array<void*, sizeof...(Components)>& elems)const
+		{
+			for (size_t i = 0; i < _infos.size(); i++)
+			{
+				if (i == driver)
+				{
+					elems[i] = elem;
+					continue;
+				}
+				auto it = _infos[i]->entity_map.find(entity);
+				if (it == _infos[i]->entity_map.end())
+				{
+					return false;
+				}
+				elems[i] = it->second;
+			}
+			return true;
+		}
+		template<typename Func, size_t ...I>
+		static void Invoke(Func& func, EntityID entity, const std::array<void*, sizeof...(Components)>& elems,
+			std::index_sequence<I...>)
+		{
+			if constexpr (std::is_invocable_v<Func&, EntityID, Components...>)
+			{
+				func(entity, *static_cast<std::remove_reference_t<Components>*>(elems[I])...);
+			}
+			else
+			{
+				func(*static_cast<std::remove_reference_t<Components>*>(elems[I])...);
+			}
+		}
+	private:
+		std::array<Sence::ComponentInfo*, sizeof...(Components)> _infos;	///< 
+	};
+	/**
+	 * @brief , ͬʱӵȫʵһű
+	 *
+	 * ÿбʵ弰, ˳; ֡,
+	 * ¼ʵ׷ڱβ, Ƴʵȱ´αʱͳһѹ
+	 *
+	 * @tparam Components 
+	 */
+	template<typename ...Components>
+	class Group final : public Sence::GroupBase
+	{
+		static_assert(sizeof...(Components) != 0, "Ҫһ");
+	public:
+		Group() = delete;
+		Group(const Group&) = delete;
+		Group& operator = (const Group&) = delete;
+		Group(Sence& sence) :_infos{ &sence.GetComponentInfo<Components>()... }
+		{
+			(sence.OnAdd<Components>([this](EntityID entity, Components&)
+				{
+					Insert(entity);
+				}), ...);
+			(sence.OnRemove<Components>([this](EntityID entity, Components&)
+				{
+					Erase(entity);
+				}), ...);
+			(sence.OnMove<Components>([this](EntityID entity, Components& component)
+				{
+					if (auto it = _slots.find(entity);
+						it != _slots.end())
+					{
+						std::get<Components*>(_rows[it->second].elems) = &component;
+					}
+				}), ...);
+			Query<Components&...> query(sence);
+			query.Each([this](EntityID entity, Components& ...components)
+				{
+					Append(entity, &components...);
+				});
+			((_infos[IndexOf<Components>()]->layout = 0), ...);
+		}
+		/**
+		 * @brief ˳ʵ
+		 *
+		 * @param func ص, Ϊ (Components&...)  (EntityID, Components&...)
+		 */
+		template<typename Func>
+		void Each(Func&& func)
+		{
+			Compact();
+			(_infos[IndexOf<Components>()]->MarkChanged(), ...);
+			for (auto& row : _rows)
+			{
+				std::apply([&](Components* ...elems)
+					{
+						if constexpr (std::is_invocable_v<Func&, EntityID, Components&...>)
+						{
+							func(row.entity, *elems...);
+						}
+						else
+						{
+							func(*elems...);
+						}
+					}, row.elems);
+			}
+		}
+		/**
+		 * @brief ûʵȶ, Իıӽʱ
+		 *
+		 * ԭλǰ, kмٵĴλ, ֻk鲢ر;
+		 * 򲿷ֱӽ, ֻдλҪֲ, Ϊ O(n + k log n); 򴦹ʱֱ
+		 *
+		 * @param key , Ϊ (const Components&...), ؿɱȽϵļ
+		 */
+		template<typename KeyFunc>
+		void SortBy(KeyFunc&& key)
+		{
+			Compact();
+			using Key = std::decay_t<std::invoke_result_t<KeyFunc&, const Components&...>>;
+			constexpr size_t none = static_cast<size_t>(-1);
+			size_t count = _rows.size();
+			std::vector<Key> keys;
+			keys.reserve(count);
+			for (auto& row : _rows)
+			{
+				keys.push_back(std::apply([&](Components* ...elems)
+					{
+						return key(static_cast<const Components&>(*elems)...);
+					}, row.elems));
+			}
+			auto less = [&](size_t a, size_t b)
+			{
+				return keys[a] < keys[b];
+			};
+			std::vector<size_t> order;
+			order.reserve(count);
+			size_t descents = 0;
+			for (size_t i = 1; i < count; i++)
+			{
+				descents += less(i, i - 1);
+			}
+			if (descents == 0)
+			{
+				return;
+			}
+			if (descents * 8 > count)
+			{
+				// Զʱֱ
+				order.resize(count);
+				std::iota(order.begin(), order.end(), size_t(0));
+				std::stable_sort(order.begin(), order.end(), less);
+				Reorder(order);
+				return;
+			}
+			// tails[l] Ϊ l+1 ĲĩСߵĩ, prev ڻ
+			std::vector<size_t> tails;
+			std::vector<size_t> prev(count, none);
+			for (size_t i = 0; i < count; i++)
+			{
+				if (tails.empty() || !less(i, tails.back()))
+				{
+					prev[i] = tails.empty() ? none : tails.back();
+					tails.push_back(i);
+					continue;
+				}
+				auto pos = std::upper_bound(tails.begin(), tails.end(), i, less);
+				prev[i] = pos == tails.begin() ? none : *(pos - 1);
+				*pos = i;
+			}
+			std::vector<bool> kept(count, false);
+			for (size_t i = tails.back(); i != none; i = prev[i])
+			{
+				kept[i] = true;
+			}
+			std::vector<size_t> stay;
+			std::vector<size_t> moved;
+			stay.reserve(tails.size());
+			moved.reserve(count - tails.size());
+			for (size_t i = 0; i < count; i++)
+			{
+				(kept[i] ? stay : moved).push_back(i);
+			}
+			std::stable_sort(moved.begin(), moved.end(), less);
+			// ͬʱԭλ, ȶĽһ
+			std::merge(stay.begin(), stay.end(), moved.begin(), moved.end(), std::back_inserter(order),
+				[&](size_t a, size_t b)
+				{
+					return less(a, b) || (!less(b, a) && a < b);
+				});
+			Reorder(order);
+		}
+		/**
+		 * @brief ʵ
+		 */
+		size_t Size()const override
+		{
+			return _rows.size() - _removed;
+		}
+		bool Covers(ComponentID index)const override
+		{
+			return ((IndexGenerator::Get<Components>() == index) || ...);
+		}
+		bool Contains(EntityID entity)const override
+		{
+			return _slots.find(entity) != _slots.end();
+		}
+		void CollectRows(ComponentID index, std::vector<std::pair<EntityID, void*>>& rows)const override
+		{
+			constexpr size_t count = sizeof...(Components);
+			const std::array<ComponentID, count> indexs{ IndexGenerator::Get<Components>()... };
+			size_t at = std::find(indexs.begin(), indexs.end(), index) - indexs.begin();
+			assertm(at < count, "鲻");
+			rows.reserve(rows.size() + Size());
+			for (auto& row : _rows)
+			{
+				if (row.entity == removed_entity)
+				{
+					continue;
+				}
+				std::array<void*, count> elems{ static_cast<void*>(std::get<Components*>(row.elems))... };
+				rows.emplace_back(row.entity, elems[at]);
+			}
+		}
+		ChangeTick::Tick Order()const override
+		{
+			return _order;
+		}
+		void SaveOrder(std::vector<EntityID>& entitys)const override
+		{
+			entitys.reserve(Size());
+			for (auto& row : _rows)
+			{
+				if (row.entity != removed_entity)
+				{
+					entitys.push_back(row.entity);
+				}
+			}
+		}
+		void RestoreOrder(const std::vector<EntityID>& entitys, ChangeTick::Tick order) override
+		{
+			Compact();
+			std::vector<Row> rows;
+			rows.reserve(_rows.size());
+			std::vector<bool> placed(_rows.size(), false);
+			for (auto entity : entitys)
+			{
+				if (auto it = _slots.find(entity);
+					it != _slots.end())
+				{
+					rows.push_back(_rows[it->second]);
+					placed[it->second] = true;
+				}
+			}
+			for (size_t i = 0; i < _rows.size(); i++)
+			{
+				if (!placed[i])
+				{
+					rows.push_back(_rows[i]);
+				}
+			}
+			_rows.swap(rows);
+			for (size_t i = 0; i < _rows.size(); i++)
+			{
+				_slots[_rows[i].entity] = i;
+			}
+			((_infos[IndexOf<Components>()]->layout = 0), ...);
+			_order = order;
+		}
+		/**
+		 * @brief ˳ȡʵ
+		 */
+		std::vector<EntityID> GetEntitys()
+		{
+			Compact();
+			std::vector<EntityID> entitys;
+			entitys.reserve(_rows.size());
+			for (auto& row : _rows)
+			{
+				entitys.push_back(row.entity);
+			}
+			return entitys;
+		}
+	private:
+		static constexpr EntityID removed_entity = -1;	///< Ƴеʵ
+		/**
+		 * @brief ڵһ
+		 */
+		struct Row
+		{
+			EntityID entity;
+			std::tuple<Components*...> elems;
+		};
+		template<typename C>
+		static constexpr size_t IndexOf()
+		{
+			constexpr bool match[] = { std::is_same_v<C, Components>... };
+			size_t index = 0;
+			while (!match[index])
+			{
+				index++;
+			}
+			return index;
+		}
+		/**
+		 * @brief ʵӵȫʱβ
+		 */
+		void Insert(EntityID entity)
+		{
+			if (_slots.find(entity) != _slots.end())
+			{
+				return;
+			}
+			std::array<void*, sizeof...(Components)> elems;
+			for (size_t i = 0; i < _infos.size(); i++)
+			{
+				auto it = _infos[i]->entity_map.find(entity);
+				if (it == _infos[i]->entity_map.end())
+				{
+					return;
+				}
+				elems[i] = it->second;
+			}
+			Append(entity, static_cast<Components*>(elems[IndexOf<Components>()])...);
+		}
+		void Append(EntityID entity, Components* ...elems)
+		{
+			_slots[entity] = _rows.size();
+			_rows.push_back(Row{ entity, std::make_tuple(elems...) });
+			_order = ChangeTick::Next();
+		}
+		void Erase(EntityID entity)
+		{
+			if (auto it = _slots.find(entity);
+				it != _slots.end())
+			{
+				_rows[it->second].entity = removed_entity;
+				_slots.erase(it);
+				_removed++;
+				_order = ChangeTick::Next();
+			}
+		}
+		/**
+		 * @brief ˳Ÿ
+		 *
+		 * @param order ˳ÿһԭе±
+		 */
+		void Reorder(const std::vector<size_t>& order)
+		{
+			std::vector<Row> rows;
+			rows.reserve(order.size());
+			for (auto i : order)
+			{
+				rows.push_back(_rows[i]);
+			}
+			_rows.swap(rows);
+			for (size_t i = 0; i < order.size(); i++)
+			{
+				if (order[i] != i)
+				{
+					_slots[_rows[i].entity] = i;
+				}
+			}
+			// а˳, ˳ı¼洢
+			((_infos[IndexOf<Components>()]->layout = 0), ...);
+			_order = ChangeTick::Next();
+		}
+		/**
+		 * @brief ѹƳ, е˳
+		 */
+		void Compact()
+		{
+			if (_removed == 0)
+			{
+				return;
+			}
+			size_t count = 0;
+			for (size_t i = 0; i < _rows.size(); i++)
+			{
+				if (_rows[i].entity == removed_entity)
+				{
+					continue;
+				}
+				if (count != i)
+				{
+					_rows[count] = _rows[i];
+					_slots[_rows[count].entity] = count;
+				}
+				count++;
+			}
+			_rows.resize(count);
+			_removed = 0;
+		}
+	private:
+		std::array<Sence::ComponentInfo*, sizeof...(Components)> _infos;	///< 
+		std::vector<Row> _rows;		///< ˳е
+		std::unordered_map<EntityID, size_t> _slots;	///< ʵڵ
+		size_t _removed = 0;		///< ѱƳ
+		ChangeTick::Tick _order = 0;	///< ˳ıʶ
+	};
+	/**
+	 * @brief Դ, ϵͳʱȡ
+	 *
+	 * @tparam T Դ, const ʾֻ
+	 */
+	template<typename T>
+	class Res final
+	{
+	public:
+		Res(T* resource) :_resource(resource)
+		{}
+		T& operator*()const
+		{
+			assertm(_resource, "Դ");
+			return *_resource;
+		}
+		T* operator->()const
+		{
+			assertm(_resource, "Դ");
+			return _resource;
+		}
+		explicit operator bool()const
+		{
+			return _resource != nullptr;
+		}
+	private:
+		T* _resource;
+	};
+	/**
+	 * @brief ¼Ͳ
+	 *
+	 * @tparam T ¼
+	 */
+	template<typename T>
+	class EventWriter final
+	{
+	public:
+		EventWriter(Event& event) :_event(event)
+		{}
+		EventWriter& Send(T data)
+		{
+			_event.Send<T>(std::move(data));
+			return *this;
+		}
+		EventWriter& SendIns(T data)
+		{
+			_event.SendIns<T>(std::move(data));
+			return *this;
+		}
+	private:
+		Event& _event;
+	};
+	/**
+	 * @brief ¼ȡ
+	 *
+	 * @tparam T ¼
+	 */
+	template<typename T>
+	class EventReader final
+	{
+	public:
+		EventReader(Event& event) :_event(event)
+		{}
+		bool Has()const
+		{
+			return _event.Has<T>();
+		}
+		T& Get()const
+		{
+			return _event.Get<T>();
+		}
+	private:
+		Event& _event;
+	};
+	/**
+	 * @brief : Դϵͳϴк, Ƴ, д Res<T> ʻ Resource::MarkChanged 
+	 *
+	 * @tparam T Դ
+	 */
+	template<typename T>
+	struct ResourceChanged
+	{};
+	/**
+	 * @brief : ϵͳϴкյ¼
+	 *
+	 * @tparam T ¼
+	 */
+	template<typename T>
+	struct EventPresent
+	{};
+	/**
+	 * @brief : ͬʱӵȫʵ
+	 *
+	 * @tparam Components 
+	 */
+	template<typename ...Components>
+	struct QueryNonEmpty
+	{};
+	/**
+	 * @brief : һϵͳϴк޸, ӵиʵ弯Ϸ仯
+	 *
+	 * @tparam Components 
+	 */
+	template<typename ...Components>
+	struct AnyChanged
+	{};
+	/**
+	 * @brief : ϵͳʵһϵͳϴк޸, ӵиʵ弯Ϸ仯
+	 */
+	struct AccessChanged
+	{};
+	/**
+	 * @brief ϵͳע뷽ʽ
+	 *
+	 * Init עʱ, ɲ״̬¼ʼ; Fetch ÿεϵͳʱɲ
+	 */
+	template<typename P>
+	struct SystemParam
+	{
+		static_assert(sizeof(P) == 0, "ֵ֧ϵͳ");
+	};
+	template<>
+	struct SystemParam<Command>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, Access&)
+		{
+			return {};
+		}
+		static Command& Fetch(State&, Sence&, Command& cmd, Event&)
+		{
+			return cmd;
+		}
+	};
+	template<>
+	struct SystemParam<Queryer>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, Access&)
+		{
+			return {};
+		}
+		static Queryer Fetch(State&, Sence& sence, Command&, Event&)
+		{
+			return Queryer{ sence };
+		}
+	};
+	template<>
+	struct SystemParam<Resource>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, Access&)
+		{
+			return {};
+		}
+		static Resource Fetch(State&, Sence& sence, Command&, Event&)
+		{
+			return Resource{ sence };
+		}
+	};
+	template<>
+	struct SystemParam<Event>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, Access&)
+		{
+			return {};
+		}
+		static Event& Fetch(State&, Sence&, Command&, Event& event)
+		{
+			return event;
+		}
+	};
+	template<typename ...Components>
+	struct SystemParam<Query<Components...>>
+	{
+		using State = Query<Components...>;
+		template<typename Access>
+		static State Init(Sence& sence, Access& access)
+		{
+			State::Access(access.reads, access.writes);
+			return State(sence);
+		}
+		static State& Fetch(State& state, Sence&, Command&, Event&)
+		{
+			return state;
+		}
+	};
+	template<typename ...Components>
+	struct SystemParam<Group<Components...>>
+	{
+		using State = Group<Components...>*;
+		template<typename Access>
+		static State Init(Sence& sence, Access& access)
+		{
+			(access.writes.push_back(IndexGenerator::Get<Components>()), ...);
+			return &sence.GetGroup<Components...>();
+		}
+		static Group<Components...>& Fetch(State& state, Sence&, Command&, Event&)
+		{
+			return *state;
+		}
+	};
+	template<typename T>
+	struct SystemParam<Res<T>>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, Access&)
+		{
+			return {};
+		}
+		static Res<T> Fetch(State&, Sence& sence, Command&, Event&)
+		{
+			using U = std::remove_const_t<T>;
+			Resource res{ sence };
+			if (!res.Has<U>())
+			{
+				return Res<T>(nullptr);
+			}
+			if constexpr (std::is_const_v<T>)
+			{
+				return Res<T>(&static_cast<const Resource&>(res).Get<U>());
+			}
+			else
+			{
+				res.MarkChanged<U>();
+				return Res<T>(&res.Get<U>());
+			}
+		}
+	};
+	template<typename T>
+	struct SystemParam<EventWriter<T>>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, Access&)
+		{
+			return {};
+		}
+		static EventWriter<T> Fetch(State&, Sence&, Command&, Event& event)
+		{
+			return EventWriter<T>(event);
+		}
+	};
+	template<typename T>
+	struct SystemParam<EventReader<T>>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, Access&)
+		{
+			return {};
+		}
+		static EventReader<T> Fetch(State&, Sence&, Command&, Event& event)
+		{
+			return EventReader<T>(event);
+		}
+	};
+	/**
+	 * @brief ֵʽ, ĬϽܷboolĿɵö
+	 *
+	 * Init עʱ, ״̬, access Ϊϵͳʼ; Check ÿ֡ϵͳǰ, since Ϊϵͳϴеʱ
+	 */
+	template<typename C>
+	struct RunCondition
+	{
+		static_assert(std::is_invocable_r_v<bool, C&>, "ֵ֧");
+		using State = C;
+		template<typename Access>
+		static State Init(Sence&, const Access&, C condition)
+		{
+			return condition;
+		}
+		static bool Check(State& state, Sence&, ChangeTick::Tick)
+		{
+			return state();
+		}
+	};
+	template<typename T>
+	struct RunCondition<ResourceChanged<T>>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, const Access&, ResourceChanged<T>)
+		{
+			return {};
+		}
+		static bool Check(State&, Sence& sence, ChangeTick::Tick since)
+		{
+			auto it = sence._resources.find(IndexGenerator::Get<T>());
+			return it != sence._resources.end() && it->second.version > since;
+		}
+	};
+	template<typename T>
+	struct RunCondition<EventPresent<T>>
+	{
+		struct State {};
+		template<typename Access>
+		static State Init(Sence&, const Access&, EventPresent<T>)
+		{
+			return {};
+		}
+		static bool Check(State&, Sence&, ChangeTick::Tick since)
+		{
+			return EventMessage<T>::Has() && EventMessage<T>::LastUpdate() > since;
+		}
+	};
+	template<typename ...Components>
+	struct RunCondition<QueryNonEmpty<Components...>>
+	{
+		using State = Query<const Components&...>;
+		template<typename Access>
+		static State Init(Sence& sence, const Access&, QueryNonEmpty<Components...>)
+		{
+			return State(sence);
+		}
+		static bool Check(State& state, Sence&, ChangeTick::Tick)
+		{
+			return !state.Empty();
+		}
+	};
+	template<typename ...Components>
+	struct RunCondition<AnyChanged<Components...>>
+	{
+		using State = std::array<Sence::ComponentInfo*, sizeof...(Components)>;
+		template<typename Access>
+		static State Init(Sence& sence, const Access&, AnyChanged<Components...>)
+		{
+			return { &sence.GetComponentInfo<Components>()... };
+		}
+		static bool Check(State& state, Sence&, ChangeTick::Tick since)
+		{
+			for (auto info : state)
+			{
+				if (info->version > since)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+	template<>
+	struct RunCondition<AccessChanged>
+	{
+		using State = std::vector<Sence::ComponentInfo*>;
+		template<typename Access>
+		static State Init(Sence& sence, const Access& access, AccessChanged)
+		{
+			std::vector<ComponentID> indices(access.reads);
+			indices.insert(indices.end(), access.writes.begin(), access.writes.end());
+			std::sort(indices.begin(), indices.end());
+			indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+			State state;
+			for (auto index : indices)
+			{
+				// ״̬ʱѴ˷ʵ
+				auto it = sence._components.find(index);
+				assertm(it != sence._components.end(), "в");
+				state.push_back(&it->second);
+			}
+			return state;
+		}
+		static bool Check(State& state, Sence&, ChangeTick::Tick since)
+		{
+			for (auto info : state)
+			{
+				if (info->version > since)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+	//------------------------------------------------------------------------------
+	inline void Sence::Start()
+	{
+		std::vector<Command> cmd_list;
+		_eventSystem = new EventSystem(*this);
+		for (auto& sys : _updateSystems)
+		{
+			if (!sys.run)
+			{
+				sys.bind(sys);
+			}
+		}
+		for (auto& plugin : _plugin_list)
+		{
+			plugin->Bulid(this);
+		}
+
+		for (auto sys : _startupSystems)
+		{
+			Command cmd(*this);
+			sys(cmd, Resource{ *this });
+			cmd_list.push_back(std::move(cmd));
+		}
+		for (auto& cmd : cmd_list)
+		{
+			cmd.Execute();
+		}
+	}
+	inline void Sence::Update()
+	{
+		MergeStaging(_merge_budget.count() > 0 ? TaskClock::now() + _merge_budget : TaskClock::time_point::max());
+		std::vector<Command> cmd_list;
+		Event events(*_eventSystem);
+		for (auto& sys : _updateSystems)
+		{
+			if (!sys.ShouldRun())
+			{
+				continue;
+			}
+			Command cmd(*this);
+			sys.run(cmd, events);
+			sys.last_run = ChangeTick::Now();
+			cmd_list.push_back(std::move(cmd));
+		}
+		std::exception_ptr error;
+		if (!_tasks.empty())
+		{
+			Command cmd(*this);
+			error = RunTasks(cmd, events);
+			cmd_list.push_back(std::move(cmd));
+		}
+		
+		_eventSystem->UpdateList();
+
+		for (auto& cmd : cmd_list)
+		{
+			cmd.Execute();
+		}
+		if (_defrag_budget.count() > 0)
+		{
+			Defragment(_defrag_budget);
+		}
+		_frame++;
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+	inline std::exception_ptr Sence::RunTasks(Command& cmd, Event& event)
+	{
+		auto deadline = TaskClock::now() + _task_budget;
+		size_t count = _tasks.size();
+		size_t next = (_task_cursor + 1) % count;
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t index = (_task_cursor + i) % count;
+			if (i > 0 && TaskClock::now() >= deadline)
+			{
+				next = index;
+				break;
+			}
+			auto& info = *_tasks[index];
+			if (!info.task)
+			{
+				if (_frame < info.start_frame)
+				{
+					continue;
+				}
+				info.task = info.sys(info.context);
+				info.task.GetHandle().promise().state = &info.context;
+			}
+			auto handle = info.task.GetHandle();
+			auto& promise = handle.promise();
+			if (!promise.Ready(_frame))
+			{
+				continue;
+			}
+			info.context.frame = _frame;
+			info.context.deadline = deadline;
+			info.context.resume_start = TaskClock::now();
+			info.context._cmd = &cmd;
+			info.context._event = &event;
+			handle.resume();
+			info.context._cmd = nullptr;
+			info.context._event = nullptr;
+			if (handle.done())
+			{
+				auto error = promise.error;
+				info.task.Reset();
+				info.start_frame = _frame + 1;
+				if (error)
+				{
+					_task_cursor = (index + 1) % count;
+					return error;
+				}
+			}
+		}
+		_task_cursor = next;
+		return nullptr;
+	}
+	inline bool Sence::Defragment(std::chrono::microseconds budget)
+	{
+		auto deadline = TaskClock::now() + budget;
+		bool resumed = false;
+		if (_compact)
+		{
+			if (!StepCompact(_components[_compact->index], deadline))
+			{
+				return false;
+			}
+			resumed = true;
+		}
+		std::vector<ComponentID> indexs;
+		indexs.reserve(_components.size());
+		for (auto& [index, info] : _components)
+		{
+			indexs.push_back(index);
+		}
+		std::sort(indexs.begin(), indexs.end());
+		std::vector<EntityID> entitys;
+		size_t count = indexs.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t at = (_defrag_cursor + i) % count;
+			if ((i > 0 || resumed) && TaskClock::now() >= deadline)
+			{
+				_defrag_cursor = at;
+				return false;
+			}
+			auto& info = _components[indexs[at]];
+			if (!info.ops || info.layout == info.structure)
+			{
+				continue;
+			}
+			auto stats = MeasureColumn(indexs[at], info, &entitys);
+			if (stats.scattered * 8 > stats.live || stats.cached > stats.live)
+			{
+				BeginCompact(indexs[at], info, std::move(entitys));
+				if (!StepCompact(info, deadline))
+				{
+					_defrag_cursor = (at + 1) % count;
+					return false;
+				}
+			}
+			info.layout = info.structure;
+		}
+		return true;
+	}
+	inline StorageStats Sence::GetStorageStats()
+	{
+		StorageStats stats;
+		for (auto& [index, info] : _components)
+		{
+			if (!info.ops)
+			{
+				continue;
+			}
+			auto column = MeasureColumn(index, info);
+			stats.columns += column.columns;
+			stats.live += column.live;
+			stats.cached += column.cached;
+			stats.scattered += column.scattered;
+			stats.blocks += column.blocks;
+		}
+		return stats;
+	}
+	template<typename T>
+	inline StorageStats Sence::GetStorageStats()
+	{
+		auto it = _components.find(IndexGenerator::Get<T>());
+		if (it == _components.end() || !it->second.ops)
+		{
+			return {};
+		}
+		return MeasureColumn(it->first, it->second);
+	}
+	inline StorageStats Sence::MeasureColumn(ComponentID index, ComponentInfo& info, std::vector<EntityID>* entitys)const
+	{
+		StorageStats stats;
+		stats.columns = 1;
+		stats.live = info.entity_map.size();
+		stats.cached = info.pool.cache.size();
+		stats.blocks = info.pool.blocks.size();
+		const char* last = nullptr;
+		if (entitys)
+		{
+			entitys->clear();
+			entitys->reserve(info.entity_map.size());
+		}
+		auto visit = [&](EntityID entity, const void* elem)
+		{
+			auto current = static_cast<const char*>(elem);
+			if (last && current != last + info.ops->size)
+			{
+				stats.scattered++;
+			}
+			last = current;
+			if (entitys)
+			{
+				entitys->push_back(entity);
+			}
+		};
+		auto group = LayoutGroup(index);
+		if (!group)
+		{
+			for (auto& [entity, elem] : info.Rows())
+			{
+				visit(entity, elem);
+			}
+			return stats;
+		}
+		std::vector<std::pair<EntityID, void*>> rows;
+		group->CollectRows(index, rows);
+		for (auto& [entity, elem] : rows)
+		{
+			visit(entity, elem);
+		}
+		if (rows.size() < info.entity_map.size())
+		{
+			for (auto& [entity, elem] : info.Rows())
+			{
+				if (!group->Contains(entity))
+				{
+					visit(entity, elem);
+				}
+			}
+		}
+		return stats;
+	}
+	inline const Sence::GroupBase* Sence::LayoutGroup(ComponentID index)const
+	{
+		const GroupBase* layout = nullptr;
+		int layout_key = 0;
+		for (auto& [key, group] : _groups)
+		{
+			if (!group || !group->Covers(index))
+			{
+				continue;
+			}
+			if (!layout || group->Size() > layout->Size() || (group->Size() == layout->Size() && key < layout_key))
+			{
+				layout = group.get();
+				layout_key = key;
+			}
+		}
+		return layout;
+	}
+	inline void Sence::BeginCompact(ComponentID index, ComponentInfo& info, std::vector<EntityID>&& entitys)
+	{
+		_compact = std::make_unique<CompactPass>();
+		auto& pass = *_compact;
+		pass.index = index;
+		pass.structure = info.structure;
+		pass.entitys = std::move(entitys);
+		pass.moved.reserve(pass.entitys.size());
+		// жλھڴ, Ƴڼ䱻·
+		pass.released.swap(info.pool.cache);
+		pass.old_blocks = info.pool.blocks.size();
+	}
+	inline bool Sence::StepCompact(ComponentInfo& info, TaskClock::time_point deadline)
+	{
+		constexpr size_t step = 1024;
+		auto& pass = *_compact;
+		auto& pool = info.pool;
+		auto ops = info.ops;
+		std::vector<std::pair<const EntityID, void*>*> chunk;
+		while (pass.cursor < pass.entitys.size())
+		{
+			// ÿһڴ, ʼƳʵ
+			chunk.clear();
+			size_t end = std::min(pass.entitys.size(), pass.cursor + step);
+			for (; pass.cursor < end; pass.cursor++)
+			{
+				if (auto it = info.entity_map.find(pass.entitys[pass.cursor]);
+					it != info.entity_map.end())
+				{
+					chunk.push_back(&*it);
+				}
+			}
+			if (!chunk.empty())
+			{
+				void* block = ops->create_array(chunk.size());
+				pool.blocks.emplace_back(static_cast<char*>(block), static_cast<char*>(block) + chunk.size() * ops->size);
+				for (size_t i = 0; i < chunk.size(); i++)
+				{
+					auto& [entity, elem] = *chunk[i];
+					void* dst = ops->At(block, i);
+					ops->move(dst, elem);
+					pass.released.push_back(elem);
+					elem = dst;
+					info.FindRow(entity)->second = dst;
+					auto it = _entitys.find(entity);
+					assertm(it != _entitys.end(), "ʵ岻");
+					it->second[pass.index] = dst;
+					pool.instances.push_back(dst);
+					pass.moved.push_back(dst);
+					for (auto& hook : info.on_move)
+					{
+						hook(entity, dst);
+					}
+				}
+			}
+			if (TaskClock::now() >= deadline)
+			{
+				return false;
+			}
+		}
+		if (!pass.finished)
+		{
+			FinishCompactMove(info);
+			pass.finished = true;
+		}
+		// ڶһͷ, ͷ
+		auto& blocks = pass.owned_blocks;
+		while (pass.release_cursor < pass.released.size())
+		{
+			size_t end = std::min(pass.released.size(), pass.release_cursor + step);
+			for (; pass.release_cursor < end; pass.release_cursor++)
+			{
+				void* elem = pass.released[pass.release_cursor];
+				if (FindBlock(blocks, elem) == blocks.end())
+				{
+					ops->destory(elem);
+				}
+			}
+			if (pass.release_cursor < pass.released.size() && TaskClock::now() >= deadline)
+			{
+				return false;
+			}
+		}
+		for (auto& [begin, end] : pass.dead_blocks)
+		{
+			ops->destory_array(begin);
+		}
+		info.layout = pass.structure;
+		_compact.reset();
+		return true;
+	}
+	inline void Sence::FinishCompactMove(ComponentInfo& info)
+	{
+		auto& pass = *_compact;
+		auto& pool = info.pool;
+		// ڼٵĶ˶صĻ, поڴеĶ, һͷ
+		pass.released.insert(pass.released.end(), pool.cache.begin(), pool.cache.end());
+		pool.cache.clear();
+		pool.cache.shrink_to_fit();
+		// öֻʵʹõ, ޳Ƴԭж
+		std::vector<std::pair<char*, char*>> old_blocks(pool.blocks.begin(), pool.blocks.begin() + pass.old_blocks);
+		std::sort(old_blocks.begin(), old_blocks.end());
+		std::vector<bool> used(old_blocks.size(), false);
+		if (!pass.changed && info.structure == pass.structure)
+		{
+			// ʵ弯δ, ڴ
+			pool.instances.swap(pass.moved);
+		}
+		else
+		{
+			pool.instances.clear();
+			pool.instances.reserve(info.entity_map.size());
+			for (auto& [entity, elem] : info.entity_map)
+			{
+				pool.instances.push_back(elem);
+				// ڼʵܸ˾ڴеĶ, ڴ豣
+				if (auto it = FindBlock(old_blocks, elem);
+					it != old_blocks.end())
+				{
+					used[it - old_blocks.begin()] = true;
+				}
+			}
+		}
+		std::vector<std::pair<char*, char*>> blocks;
+		blocks.reserve(pool.blocks.size());
+		for (size_t i = 0; i < old_blocks.size(); i++)
+		{
+			(used[i] ? blocks : pass.dead_blocks).push_back(old_blocks[i]);
+		}
+		blocks.insert(blocks.end(), pool.blocks.begin() + pass.old_blocks, pool.blocks.end());
+		pool.blocks.swap(blocks);
+		pass.owned_blocks = pool.blocks;
+		pass.owned_blocks.insert(pass.owned_blocks.end(), pass.dead_blocks.begin(), pass.dead_blocks.end());
+		std::sort(pass.owned_blocks.begin(), pass.owned_blocks.end());
+	}
+	inline std::vector<std::pair<char*, char*>>::const_iterator Sence::FindBlock(
+		const std::vector<std::pair<char*, char*>>& blocks, void* elem)
+	{
+		auto address = static_cast<char*>(elem);
+		auto it = std::upper_bound(blocks.begin(), blocks.end(), address,
+			[](char* address, const std::pair<char*, char*>& block)
+			{
+				return address < block.first;
+			});
+		if (it == blocks.begin() || address >= std::prev(it)->second)
+		{
+			return blocks.end();
+		}
+		return std::prev(it);
+	}
+	template<typename ...Components>
+	inline Group<Components...>& Sence::GetGroup()
+	{
+		auto index = IndexGenerator::Get<Group<Components...>>();
+		auto& group = _groups[index];
+		if (!group)
+		{
+			group = std::make_unique<Group<Components...>>(*this);
+		}
+		return static_cast<Group<Components...>&>(*group);
+	}
+	template<typename T>
+	inline Shared<std::decay_t<T>> Sence::Share(T&& value)
+	{
+		using U = std::decay_t<T>;
+		std::shared_ptr<void> store;
+		{
+			std::lock_guard<std::mutex> lock(_shared_mutex);
+			auto& entry = _shared[IndexGenerator::Get<Shared<U>>()];
+			if (!entry)
+			{
+				entry = std::make_shared<SharedStore<U>>();
+			}
+			store = entry;
+		}
+		return static_cast<SharedStore<U>*>(store.get())->Intern(std::forward<T>(value));
+	}
+	template<typename T>
+	inline size_t Sence::SharedCount()
+	{
+		std::shared_ptr<void> store;
+		{
+			std::lock_guard<std::mutex> lock(_shared_mutex);
+			auto it = _shared.find(IndexGenerator::Get<Shared<T>>());
+			if (it == _shared.end())
+			{
+				return 0;
+			}
+			store = it->second;
+		}
+		return static_cast<SharedStore<T>*>(store.get())->Size();
+	}
+	inline void Sence::Splice(StagingWorld&& staging)
+	{
+		std::lock_guard<std::mutex> lock(_staging_mutex);
+		_staging.push_back(std::move(staging));
+	}
+	inline bool Sence::MergeStaging(TaskClock::time_point deadline)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_staging_mutex);
+			for (auto& staging : _staging)
+			{
+				_merging.push_back(std::move(staging));
+			}
+			_staging.clear();
+		}
+		while (!_merging.empty())
+		{
+			if (!_merge)
+			{
+				BeginMerge();
+			}
+			if (!StepMerge(deadline) || (!_merging.empty() && TaskClock::now() >= deadline))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	inline void Sence::BeginMerge()
+	{
+		auto& staging = _merging.front();
+		_merge = std::make_unique<MergePass>();
+		auto& pass = *_merge;
+		// ݴռһĳʵID, ʵIDֻ, 
+		pass.base = _next_entity;
+		_next_entity += static_cast<EntityID>(staging._entitys.size());
+		_entitys.reserve(_entitys.size() + staging._entitys.size());
+		for (auto& [index, column] : staging._components)
+		{
+			auto it = _components.find(index);
+			if (it == _components.end())
+			{
+				it = _components.emplace(index, ComponentInfo(column.ops)).first;
+			}
+			auto& info = it->second;
+			info.entity_map.reserve(info.entity_map.size() + column.rows.size());
+			info.rows.reserve(info.rows.size() + column.rows.size());
+			// ֱƽ; ڲʱƽ, ֮ǰɲȳ
+			info.pool.cache.insert(info.pool.cache.end(), column.pool.cache.begin(), column.pool.cache.end());
+			column.pool.cache.clear();
+			column.pool.instances.clear();
+			pass.columns.emplace_back(&info, &column);
+		}
+		pass.rows.assign(pass.columns.size(), 0);
+	}
+	inline bool Sence::StepMerge(TaskClock::time_point deadline)
+	{
+		constexpr EntityID step = 1024;
+		auto& pass = *_merge;
+		auto& staging = _merging.front();
+		EntityID count = static_cast<EntityID>(staging._entitys.size());
+		std::vector<size_t> begins(pass.columns.size());
+		while (pass.cursor < count)
+		{
+			EntityID end = std::min(count, pass.cursor + step);
+			for (EntityID local = pass.cursor; local < end; local++)
+			{
+				bool inserted = _entitys.emplace(pass.base + local, std::move(staging._entitys[local])).second;
+				assertm(inserted, "ʵIDͻ");
+			}
+			// ݴаݴʵID, ενڳе򲿷֮
+			for (size_t i = 0; i < pass.columns.size(); i++)
+			{
+				auto& [info, column] = pass.columns[i];
+				auto& row = pass.rows[i];
+				begins[i] = row;
+				for (; row < column->rows.size() && column->rows[row].first < end; row++)
+				{
+					auto [local, elem] = column->rows[row];
+					info->Insert(pass.base + local, elem);
+					info->pool.instances.push_back(elem);
+				}
+				if (row != begins[i])
+				{
+					info->MarkStructure();
+				}
+			}
+			for (size_t i = 0; i < pass.columns.size(); i++)
+			{
+				auto& [info, column] = pass.columns[i];
+				if (info->on_add.empty())
+				{
+					continue;
+				}
+				for (size_t row = begins[i]; row < pass.rows[i]; row++)
+				{
+					auto [local, elem] = column->rows[row];
+					for (auto& hook : info->on_add)
+					{
+						hook(pass.base + local, elem);
+					}
+				}
+			}
+			pass.cursor = end;
+			if (pass.cursor < count && TaskClock::now() >= deadline)
+			{
+				return false;
+			}
+		}
+		_merge.reset();
+		_merging.erase(_merging.begin());
+		return true;
+	}
+	inline void Sence::AbortMerge()
+	{
+		if (!_merge)
+		{
+			return;
 		}
-		/**
-		 * @brief ȡʵӵе
-		 *
-		 * @tparam Component 
-		 * @param entity ʵ
-		 * @return 
-		 */
-		template<typename Component>
-		Component& GetComponent(EntityID entity)
+		auto& pass = *_merge;
+		for (size_t i = 0; i < pass.columns.size(); i++)
 		{
-			auto index = IndexGenerator::Get<Component>();
-			assertm(sence._entitys[entity][index], "");
-			return *((Component*)sence._entitys[entity][index]);
+			auto column = pass.columns[i].second;
+			for (size_t row = pass.rows[i]; row < column->rows.size(); row++)
+			{
+				column->ops->destory(column->rows[row].second);
+			}
 		}
-	private:
-		/**
-		 * @brief ʵ״βѯַ
-		 *
-		 * @tparam T ״
-		 * @tparam Remain ʣ
-		 * @param entity_list ѯʵб
-		 */
-		template<typename T, typename ...Remain>
-		void QueryEntitys(std::vector<EntityID>& entity_list)const
+		_merge.reset();
+		_merging.erase(_merging.begin());
+	}
+	inline int Sence::SaveCheckpoint()
+	{
+		if (_merge)
 		{
-			auto index = IndexGenerator::Get<T>();
-			Sence::ComponentInfo& info = sence._components[index];
-			for (auto& e : info.entity_map)
+			StepMerge(TaskClock::time_point::max());
+		}
+		Checkpoint checkpoint;
+		checkpoint.frame = _frame;
+		checkpoint.next_entity = _next_entity;
+		const Checkpoint* last = _checkpoints.empty() ? nullptr : &_checkpoints.back();
+		for (auto& [index, info] : _components)
+		{
+			if (!info.ops)
 			{
-				if constexpr (sizeof...(Remain) != 0)
-				{
-					QueryEntitysRemain<Remain...>(e.first, entity_list);
-				}
-				else
+				continue;
+			}
+			if (last)
+			{
+				if (auto it = last->columns.find(index);
+					it != last->columns.end() && it->second->state == info.state)
 				{
-					entity_list.push_back(e.first);
+					checkpoint.columns.emplace(index, it->second);
+					continue;
 				}
 			}
+			checkpoint.columns.emplace(index, CaptureColumn(info));
 		}
-		/**
-		 * @brief Էϳνʵʣвѯ
-		 *
-		 * @tparam T 
-		 * @tparam Remain ʣ
-		 * @param entity_list ѯʵб
-		 */
-		template<typename T, typename ...Remain>
-		void QueryEntitysRemain(EntityID entity, std::vector<EntityID>& entity_list)const
+		for (auto& [key, group] : _groups)
 		{
-			auto index = IndexGenerator::Get<T>();
-			auto& container = sence._entitys[entity];
-			if (auto it = container.find(index);
-				it == container.end())
+			if (!group)
 			{
-				return;
+				continue;
 			}
-			if constexpr (sizeof...(Remain) != 0)
+			if (last)
 			{
-				QueryEntitysRemain<Remain...>(entity, entity_list);
+				if (auto it = last->groups.find(key);
+					it != last->groups.end() && it->second->order == group->Order())
+				{
+					checkpoint.groups.emplace(key, it->second);
+					continue;
+				}
 			}
-			else
+			auto snapshot = std::make_shared<GroupSnapshot>();
+			snapshot->order = group->Order();
+			group->SaveOrder(snapshot->entitys);
+			checkpoint.groups.emplace(key, std::move(snapshot));
+		}
+		checkpoint.resources.reserve(_resource_tracks.size());
+		for (auto& track : _resource_tracks)
+		{
+			auto it = _resources.find(track.index);
+			if (it == _resources.end() || !it->second.resource)
 			{
-				entity_list.push_back(entity);
+				checkpoint.resources.emplace_back();
+				continue;
 			}
+			checkpoint.resources.emplace_back(track.clone(it->second.resource), track.destory);
 		}
-	private:
-		Sence& sence;
-	};
-	class EventSystem final
+		if (last && last->frame == _frame)
+		{
+			_checkpoints.pop_back();
+		}
+		_checkpoints.push_back(std::move(checkpoint));
+		while (_checkpoints.size() > _checkpoint_depth)
+		{
+			_checkpoints.pop_front();
+		}
+		return _frame;
+	}
+	inline bool Sence::RestoreCheckpoint(int frame)
 	{
-	public:
-		friend class Sence;
-		friend class Event;
-		EventSystem() = delete;
-		EventSystem(Sence& sence) :_sence(sence)
-		{}
-		~EventSystem() = default;
-	private:
-		template<typename T>
-		void Send(T&& data)
+		auto it = std::find_if(_checkpoints.begin(), _checkpoints.end(), [frame](const Checkpoint& checkpoint)
+			{
+				return checkpoint.frame == frame;
+			});
+		if (it == _checkpoints.end())
 		{
-			EventMessage<T>::Set(std::forward<T>(data));
-			_update_list.push_back(EventMessage<T>::Update);
+			return false;
 		}
-		template<typename T>
-		void SendFuture(T&& data, float time)
-		{}
-		template<typename T>
-		bool Has()
+		// еݴռóʵID, ɲ, ʵһͬص
+		if (_merge)
 		{
-			return EventMessage<T>::Has();
+			StepMerge(TaskClock::time_point::max());
 		}
-		template<typename T>
-		T& Get()
+		std::vector<std::tuple<ComponentInfo*, EntityID, void*>> added;
+		for (auto& [index, info] : _components)
 		{
-			assertm(EventMessage<T>::Has(), "¼");
-			auto& msg = EventMessage<T>::Get().value();
-			return msg;
+			if (!info.ops)
+			{
+				continue;
+			}
+			auto column = it->columns.find(index);
+			RestoreColumn(index, info, column == it->columns.end() ? nullptr : column->second.get(), added);
 		}
-		template<typename T>
-		void Clear()
+		for (auto& [info, entity, elem] : added)
 		{
-			EventMessage<T>::Clear();
+			for (auto& hook : info->on_add)
+			{
+				hook(entity, elem);
+			}
 		}
-		template<typename T>
-		void Update()
+		// صɾڱβ, ʱ˳
+		for (auto& [key, group] : _groups)
 		{
-			EventMessage<T>::Update();
+			if (auto saved = it->groups.find(key);
+				group && saved != it->groups.end() && group->Order() != saved->second->order)
+			{
+				group->RestoreOrder(saved->second->entitys, saved->second->order);
+			}
 		}
-		void UpdateList()
+		for (size_t i = 0; i < it->resources.size(); i++)
 		{
-			for (auto e : _update_list)
+			auto& track = _resource_tracks[i];
+			auto& value = it->resources[i];
+			auto res = _resources.find(track.index);
+			if (!value)
 			{
-				e();
+				if (res != _resources.end() && res->second.resource)
+				{
+					res->second.destory(res->second.resource);
+					res->second.resource = nullptr;
+					res->second.version = ChangeTick::Next();
+				}
+				continue;
+			}
+			if (res == _resources.end())
+			{
+				res = _resources.emplace(track.index, ResourceInfo(track.destory)).first;
 			}
+			if (res->second.resource)
+			{
+				track.assign(res->second.resource, value.get());
+			}
+			else
+			{
+				res->second.resource = track.clone(value.get());
+			}
+			res->second.version = ChangeTick::Next();
 		}
-	private:
-		Sence& _sence;
-		using updateFunc = void(*)(void);
-		std::vector<updateFunc> _update_list;
-	};
-	class Event
+		_next_entity = it->next_entity;
+		_frame = it->frame;
+		_checkpoints.erase(std::next(it), _checkpoints.end());
+		return true;
+	}
+	inline std::shared_ptr<const Sence::ColumnSnapshot> Sence::CaptureColumn(ComponentInfo& info)
 	{
-	public:
-		Event(EventSystem& event_system) :_event_system(event_system)
-		{}
-		template<typename T>
-		Event& Send(T&& data)
+		auto snapshot = std::make_shared<ColumnSnapshot>();
+		snapshot->ops = info.ops;
+		snapshot->state = info.state;
+		snapshot->structure = info.structure;
+		auto& rows = info.Rows();
+		snapshot->entitys.reserve(rows.size());
+		if (!rows.empty())
 		{
-			_event_system.Send(std::forward<T>(data));
-			return *this;
+			snapshot->values = info.ops->create_array(rows.size());
 		}
-		template<typename T>
-		Event& SendIns(T&& data)
+		for (auto& [entity, elem] : rows)
 		{
-			_event_system.Send(std::forward<T>(data));
-			_event_system.Update<T>();
-			return *this;
+			info.ops->copy(info.ops->At(snapshot->values, snapshot->entitys.size()), elem);
+			snapshot->entitys.push_back(entity);
 		}
-		template<typename T>
-		Event& SendFuture(T&& data, float time)
-		{}
-		template<typename T>
-		bool Has()
+		return snapshot;
+	}
+	inline void Sence::RestoreColumn(ComponentID index, ComponentInfo& info, const ColumnSnapshot* snapshot,
+		std::vector<std::tuple<ComponentInfo*, EntityID, void*>>& added)
+	{
+		if (snapshot && info.state == snapshot->state)
 		{
-			return _event_system.Has<T>();
+			return;
 		}
-		template<typename T>
-		T& Get()
+		auto& rows = info.Rows();
+		if (snapshot && info.structure == snapshot->structure)
 		{
-			return _event_system.Get<T>();
+			// ʵ弯δ, ߰ʵIDжӦ
+			assertm(rows.size() == snapshot->entitys.size(), "ʵ弯ղһ");
+			for (size_t i = 0; i < rows.size(); i++)
+			{
+				assertm(rows[i].first == snapshot->entitys[i], "ʵ弯ղһ");
+				info.ops->copy(rows[i].second, info.ops->At(snapshot->values, i));
+			}
+			// ݱʶص, 仯ʱǰƽ, ʹ仯ϵͳڻָ
+			info.state = snapshot->state;
+			info.version = ChangeTick::Next();
+			return;
 		}
-		template<typename T>
-		Event& Clear()
+		// ʵ弯ϻصպ¼洢, ʶǡûصʼʱֵ
+		info.layout = 0;
+		if (_compact && _compact->index == index)
 		{
-			_event_system.Clear<T>();
-			return *this;
+			_compact->changed = true;
 		}
-
-	private:
-		EventSystem& _event_system;
-	};
-	//------------------------------------------------------------------------------
-	inline void Sence::Start()
-	{
-		std::vector<Command> cmd_list;
-		_eventSystem = new EventSystem(*this);
-		for (auto& plugin : _plugin_list)
+		// ʵID鲢: ֻеʵڼ֮, ֻڿеʵڼ֮Ƴ
+		size_t count = snapshot ? snapshot->entitys.size() : 0;
+		std::vector<std::pair<EntityID, void*>> restored;
+		restored.reserve(count);
+		std::vector<void*> removed;
+		size_t row = 0;
+		for (size_t i = 0; i < count || row < rows.size();)
 		{
-			plugin->Bulid(this);
+			if (i == count || (row < rows.size() && rows[row].first < snapshot->entitys[i]))
+			{
+				auto [entity, elem] = rows[row++];
+				for (auto& hook : info.on_remove)
+				{
+					hook(entity, elem);
+				}
+				info.entity_map.erase(entity);
+				auto it = _entitys.find(entity);
+				it->second.erase(index);
+				if (it->second.empty())
+				{
+					_entitys.erase(it);
+				}
+				removed.push_back(elem);
+				continue;
+			}
+			EntityID entity = snapshot->entitys[i];
+			void* elem = nullptr;
+			if (row < rows.size() && rows[row].first == entity)
+			{
+				elem = rows[row++].second;
+			}
+			else
+			{
+				elem = info.pool.create();
+				info.entity_map.emplace(entity, elem);
+				_entitys[entity][index] = elem;
+				added.emplace_back(&info, entity, elem);
+			}
+			info.ops->copy(elem, info.ops->At(snapshot->values, i));
+			restored.emplace_back(entity, elem);
+			i++;
 		}
-
-		for (auto sys : _startupSystems)
+		info.pool.destory(removed);
+		info.rows.swap(restored);
+		info.sorted = info.rows.size();
+		info.removed = 0;
+		if (snapshot)
 		{
-			Command cmd(*this);
-			sys(cmd, Resource{ *this });
-			cmd_list.push_back(cmd);
+			info.state = snapshot->state;
+			info.structure = snapshot->structure;
+			info.version = ChangeTick::Next();
 		}
-		for (auto& cmd : cmd_list)
+		else
 		{
-			cmd.Execute();
+			info.MarkStructure();
 		}
 	}
-	inline void Sence::Update()
+	template<typename T>
+	inline Sence& Sence::CheckpointResource()
 	{
-		std::vector<Command> cmd_list;
-		Event events(*_eventSystem);
-		for (auto sys : _updateSystems)
-		{
-			Command cmd(*this);
-			sys(cmd, Queryer{ *this }, Resource{ *this }, events);
-			cmd_list.push_back(cmd);
-		}
-		
-		_eventSystem->UpdateList();
-
-		for (auto& cmd : cmd_list)
+		auto index = IndexGenerator::Get<T>();
+		for (auto& track : _resource_tracks)
 		{
-			cmd.Execute();
+			if (track.index == index)
+			{
+				return *this;
+			}
 		}
+		_resource_tracks.push_back(ResourceTrack{ index,
+			[](void* elem)
+			{
+				delete static_cast<T*>(elem);
+			},
+			[](const void* elem) -> void*
+			{
+				return new T(*static_cast<const T*>(elem));
+			},
+			[](void* elem, const void* value)
+			{
+				*static_cast<T*>(elem) = *static_cast<const T*>(value);
+			} });
+		return *this;
 	}
 	template<typename T>
 	inline Sence& Sence::SetResource(T&& resource)
@@ -678,6 +3901,137 @@ namespace TanmiEngine {
 		cmd.SetResource(std::forward<T>(resource));
 		return *this;
 	}
+	template<typename F, typename ...Conditions>
+	inline Sence& Sence::AddUpdateSystem(F&& sys, Conditions&& ...conditions)
+	{
+		using ArgsTuple = typename FunctionTraits<std::decay_t<F>>::ArgsTuple;
+		UpdateSystemInfo info;
+		info.bind = [this, sys = std::forward<F>(sys), ...conditions = std::forward<Conditions>(conditions)](UpdateSystemInfo& info)
+		{
+			info.run = MakeUpdateSystem(sys, info.access, static_cast<ArgsTuple*>(nullptr));
+			(info.conditions.push_back(MakeRunCondition(conditions, info.access)), ...);
+		};
+		info.bind(info);
+		_updateSystems.push_back(std::move(info));
+		return *this;
+	}
+	template<typename C>
+	inline std::function<bool(ChangeTick::Tick)> Sence::MakeRunCondition(const C& condition, const SystemAccess& access)
+	{
+		using Condition = RunCondition<C>;
+		return [this, state = Condition::Init(*this, access, condition)](ChangeTick::Tick since) mutable
+		{
+			return Condition::Check(state, *this, since);
+		};
+	}
+	template<typename F>
+	inline Sence& Sence::AddCoroutineSystem(F&& sys)
+	{
+		static_assert(std::is_invocable_r_v<Task, std::decay_t<F>&, TaskContext&>, "ЭϵͳǩӦΪ Task(TaskContext&)");
+		_tasks.push_back(std::make_unique<TaskInfo>(*this, std::forward<F>(sys)));
+		return *this;
+	}
+	template<typename F, typename ...Params>
+	inline std::function<void(Command&, Event&)> Sence::MakeUpdateSystem(const F& sys, SystemAccess& access, std::tuple<Params...>*)
+	{
+		static_assert(((!std::is_same_v<std::remove_cvref_t<Params>, Command> || std::is_lvalue_reference_v<Params>) && ...),
+			"Command Ϊ, ֵᱻִ");
+		static_assert(((!std::is_same_v<std::remove_cvref_t<Params>, Event> || std::is_lvalue_reference_v<Params>) && ...),
+			"Event Ϊ");
+		auto states = std::make_tuple(SystemParam<std::remove_cvref_t<Params>>::Init(*this, access)...);
+		return [this, sys, states = std::move(states)](Command& cmd, Event& event) mutable
+		{
+			[&]<size_t ...I>(std::index_sequence<I...>)
+			{
+				sys(SystemParam<std::remove_cvref_t<Params>>::Fetch(std::get<I>(states), *this, cmd, event)...);
+			}(std::index_sequence_for<Params...>{});
+		};
+	}
+	template<typename T>
+	inline Sence& Sence::OnAdd(std::function<void(EntityID, T&)> hook)
+	{
+		GetComponentInfo<T>().on_add.push_back([hook = std::move(hook)](EntityID entity, void* elem)
+			{
+				hook(entity, *static_cast<T*>(elem));
+			});
+		return *this;
+	}
+	template<typename T>
+	inline Sence& Sence::OnRemove(std::function<void(EntityID, T&)> hook)
+	{
+		GetComponentInfo<T>().on_remove.push_back([hook = std::move(hook)](EntityID entity, void* elem)
+			{
+				hook(entity, *static_cast<T*>(elem));
+			});
+		return *this;
+	}
+	template<typename T>
+	inline Sence& Sence::OnMove(std::function<void(EntityID, T&)> hook)
+	{
+		GetComponentInfo<T>().on_move.push_back([hook = std::move(hook)](EntityID entity, void* elem)
+			{
+				hook(entity, *static_cast<T*>(elem));
+			});
+		return *this;
+	}
+	template<typename T>
+	inline Sence::ComponentInfo& Sence::GetComponentInfo()
+	{
+		auto index = IndexGenerator::Get<T>();
+		if (auto it = _components.find(index);
+			it != _components.end())
+		{
+			return it->second;
+		}
+		return _components.emplace(index, ComponentInfo(ComponentOps::Get<T>())).first->second;
+	}
+	template<typename ...ComponentTypes>
+	inline Prefab Sence::MakePrefab(ComponentTypes&& ...components)
+	{
+		auto plan = std::make_unique<PrefabPlan>();
+		plan->columns.reserve(sizeof...(ComponentTypes));
+		(plan->columns.push_back(
+			MakePrefabColumn<std::decay_t<ComponentTypes>>(std::forward<ComponentTypes>(components))), ...);
+		_prefabs.push_back(std::move(plan));
+		return Prefab(_prefabs.back().get());
+	}
+	template<typename T, typename U>
+	inline Sence::PrefabColumn Sence::MakePrefabColumn(U&& component)
+	{
+		PrefabColumn column;
+		column.index = IndexGenerator::Get<T>();
+		column.info = &GetComponentInfo<T>();
+		column.value = new T(std::forward<U>(component));
+		return column;
+	}
+	inline void Sence::NotifyAdd(EntityID entity, const ComponentContainer& container)
+	{
+		for (auto& [index, elem] : container)
+		{
+			for (auto& hook : _components[index].on_add)
+			{
+				hook(entity, elem);
+			}
+		}
+	}
+	inline Command& TaskContext::GetCommand()
+	{
+		assertm(_cmd, "ֻЭָ̻ڼЧ");
+		return *_cmd;
+	}
+	inline Queryer TaskContext::GetQueryer()
+	{
+		return Queryer{ _sence };
+	}
+	inline Resource TaskContext::GetResource()
+	{
+		return Resource{ _sence };
+	}
+	inline Event& TaskContext::GetEvent()
+	{
+		assertm(_event, "¼ֻЭָ̻ڼЧ");
+		return *_event;
+	}
 	template<typename T>
 	inline T* Sence::GetResource()
 	{
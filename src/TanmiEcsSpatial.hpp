@@ -0,0 +1,650 @@
+/*****************************************************************//**
+ * \file   TanmiEcsSpatial.hpp
+ * \brief  ռ, Ծάλ
+ *
+ * \author tanmika
+ * \date   May 2023
+ *********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "TanmiEcs.hpp"
+
+namespace TanmiEngine {
+	/**
+	 * @brief λȡʽ, Ĭ϶ȡԱxy, ػ
+	 */
+	template<typename T>
+	struct SpatialTraits
+	{
+		static float X(const T& position)
+		{
+			return position.x;
+		}
+		static float Y(const T& position)
+		{
+			return position.y;
+		}
+	};
+	/**
+	 * @brief ռ
+	 */
+	struct SpatialPoint
+	{
+		float x;
+		float y;
+	};
+	/**
+	 * @brief ѯʹõĳפ߳, ռ, 贴һֱ
+	 */
+	class SpatialWorkers final
+	{
+	public:
+		using Job = std::function<void(size_t, size_t)>;
+		SpatialWorkers(const SpatialWorkers&) = delete;
+		SpatialWorkers& operator = (const SpatialWorkers&) = delete;
+		static SpatialWorkers& Instance()
+		{
+			static SpatialWorkers workers;
+			return workers;
+		}
+		/**
+		 * @brief  [0, count) ƽֶ, ɵ߳빤ִ̹߳ͬ, ȫɺ󷵻
+		 *
+		 * ͬһʱִֻһ, õȴ
+		 *
+		 * @param count 
+		 * @param threads ߳, ߳
+		 * @param job , Ϊ [begin, end)
+		 */
+		void Run(size_t count, size_t threads, const Job& job)
+		{
+			std::lock_guard<std::mutex> run(_run_mutex);
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				while (_threads.size() + 1 < threads)
+				{
+					_threads.emplace_back(&SpatialWorkers::Loop, this, _threads.size());
+				}
+				_job = &job;
+				_count = count;
+				_step = (count + threads - 1) / threads;
+				_next = 0;
+				_active = threads - 1;
+				_pending = _active;
+				_generation++;
+			}
+			_wake.notify_all();
+			Work();
+			std::unique_lock<std::mutex> lock(_mutex);
+			_done.wait(lock, [this]()
+				{
+					return _pending == 0;
+				});
+			_job = nullptr;
+		}
+	private:
+		SpatialWorkers() = default;
+		~SpatialWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_quit = true;
+			}
+			_wake.notify_all();
+			for (auto& thread : _threads)
+			{
+				thread.join();
+			}
+		}
+		/**
+		 * @brief ȡִзֶ, ֱȫ
+		 */
+		void Work()
+		{
+			for (size_t begin = _next.fetch_add(_step); begin < _count; begin = _next.fetch_add(_step))
+			{
+				(*_job)(begin, std::min(_count, begin + _step));
+			}
+		}
+		/**
+		 * @brief ̵߳ȴµһ, ֻбСڱ̲߳
+		 */
+		void Loop(size_t index)
+		{
+			std::uint64_t seen = 0;
+			std::unique_lock<std::mutex> lock(_mutex);
+			while (true)
+			{
+				_wake.wait(lock, [&]()
+					{
+						return _quit || _generation != seen;
+					});
+				if (_quit)
+				{
+					return;
+				}
+				seen = _generation;
+				if (index >= _active)
+				{
+					continue;
+				}
+				lock.unlock();
+				Work();
+				lock.lock();
+				if (--_pending == 0)
+				{
+					_done.notify_one();
+				}
+			}
+		}
+	private:
+		std::mutex _run_mutex;		///< 
+		std::mutex _mutex;			///< ״̬
+		std::condition_variable _wake;	///< ֪ͨ߳̿ʼµһ
+		std::condition_variable _done;	///< ֪̱ͨ߳
+		std::vector<std::thread> _threads;	///< ߳
+		const Job* _job = nullptr;	///< 
+		size_t _count = 0;			///< 
+		size_t _step = 0;			///< ֶγ
+		std::atomic<size_t> _next = 0;	///< һȡķֶ
+		size_t _active = 0;			///< Ĺ߳
+		size_t _pending = 0;		///< δɵĹ߳
+		std::uint64_t _generation = 0;	///< α
+		bool _quit = false;			///< Ƿ˳
+	};
+	/**
+	 * @brief ռ, Ծ֯ӵλʵ
+	 *
+	 * @tparam T λ
+	 */
+	template<typename T>
+	class SpatialIndex final
+	{
+	public:
+		SpatialIndex() = delete;
+		explicit SpatialIndex(float cell_size) :_cell_size(cell_size), _inv_cell_size(1.0f / cell_size)
+		{
+			assertm(cell_size > 0.0f, "ߴΪ");
+		}
+		/**
+		 * @brief ѯԲηΧڵʵ
+		 *
+		 * @param x Բx
+		 * @param y Բy
+		 * @param radius 뾶
+		 * @return ʵб
+		 */
+		std::vector<EntityID> QueryRadius(float x, float y, float radius)const
+		{
+			std::vector<EntityID> entitys;
+			QueryRadius(x, y, radius, entitys);
+			return entitys;
+		}
+		/**
+		 * @brief ѯΧڵʵ
+		 *
+		 * @param min ΧС
+		 * @param max Χ
+		 * @return ʵб
+		 */
+		std::vector<EntityID> QueryAABB(SpatialPoint min, SpatialPoint max)const
+		{
+			std::vector<EntityID> entitys;
+			QueryAABB(min, max, entitys);
+			return entitys;
+		}
+		/**
+		 * @brief ѯkʵ
+		 *
+		 * @param x ѯx
+		 * @param y ѯy
+		 * @param k 
+		 * @return ɽԶеʵб
+		 */
+		std::vector<EntityID> QueryNearest(float x, float y, size_t k)const
+		{
+			std::vector<EntityID> entitys;
+			QueryNearest(x, y, k, entitys);
+			return entitys;
+		}
+		/**
+		 * @brief вѯԲηΧ
+		 *
+		 * @param centers Բб
+		 * @param radius 뾶
+		 * @param threads ߳, Ϊ0ʱʹӲ߳
+		 * @return ԲһһӦʵб
+		 */
+		std::vector<std::vector<EntityID>> QueryRadius(const std::vector<SpatialPoint>& centers,
+			float radius, size_t threads = 0)const
+		{
+			std::vector<std::vector<EntityID>> results(centers.size());
+			ParallelFor(centers.size(), threads, [&](size_t i)
+				{
+					QueryRadius(centers[i].x, centers[i].y, radius, results[i]);
+				});
+			return results;
+		}
+		/**
+		 * @brief вѯkʵ
+		 *
+		 * @param centers ѯб
+		 * @param k 
+		 * @param threads ߳, Ϊ0ʱʹӲ߳
+		 * @return ѯһһӦʵб
+		 */
+		std::vector<std::vector<EntityID>> QueryNearest(const std::vector<SpatialPoint>& centers,
+			size_t k, size_t threads = 0)const
+		{
+			std::vector<std::vector<EntityID>> results(centers.size());
+			ParallelFor(centers.size(), threads, [&](size_t i)
+				{
+					QueryNearest(centers[i].x, centers[i].y, k, results[i]);
+				});
+			return results;
+		}
+		/**
+		 * @brief еʵ
+		 */
+		size_t Size()const
+		{
+			return _entrys.size();
+		}
+	public:
+		/**
+		 * @brief ʵ
+		 *
+		 * @param entity ʵ
+		 * @param position λ
+		 */
+		void Insert(EntityID entity, const T& position)
+		{
+			Entry entry;
+			entry.position = &position;
+			entry.x = SpatialTraits<T>::X(position);
+			entry.y = SpatialTraits<T>::Y(position);
+			entry.cell = CellOf(entry.x, entry.y);
+			Link(entity, entry);
+			_entrys[entity] = entry;
+		}
+		/**
+		 * @brief λڴ洢ƶַ
+		 *
+		 * @param entity ʵ
+		 * @param position ƶλ
+		 */
+		void Move(EntityID entity, const T& position)
+		{
+			if (auto it = _entrys.find(entity);
+				it != _entrys.end())
+			{
+				it->second.position = &position;
+			}
+		}
+		/**
+		 * @brief Ƴʵ
+		 *
+		 * @param entity ʵ
+		 */
+		void Erase(EntityID entity)
+		{
+			if (auto it = _entrys.find(entity);
+				it != _entrys.end())
+			{
+				Unlink(it->second);
+				_entrys.erase(it);
+			}
+		}
+		/**
+		 * @brief λĵǰֵ, ֻпԽʵ¹ҽ
+		 */
+		void Sync()
+		{
+			for (auto& [entity, entry] : _entrys)
+			{
+				float x = SpatialTraits<T>::X(*entry.position);
+				float y = SpatialTraits<T>::Y(*entry.position);
+				if (x == entry.x && y == entry.y)
+				{
+					continue;
+				}
+				entry.x = x;
+				entry.y = y;
+				if (auto cell = CellOf(x, y);
+					cell != entry.cell)
+				{
+					Unlink(entry);
+					entry.cell = cell;
+					Link(entity, entry);
+				}
+				else
+				{
+					auto& item = _cells[cell][entry.slot];
+					item.x = x;
+					item.y = y;
+				}
+			}
+		}
+		/**
+		 * @brief ͬĸϵͳ, λз仯Ϊע
+		 */
+		static void SyncSystem(Command&, Queryer, Resource res, Event&)
+		{
+			if (res.Has<SpatialIndex<T>>())
+			{
+				res.Get<SpatialIndex<T>>().Sync();
+			}
+		}
+	private:
+		using CellKey = std::int64_t;
+		/**
+		 * @brief еʵ
+		 */
+		struct CellItem
+		{
+			EntityID entity;
+			float x;
+			float y;
+		};
+		/**
+		 * @brief ʵ
+		 */
+		struct Entry
+		{
+			const T* position = nullptr;	///< λ
+			float x = 0.0f;			///< ϴͬx
+			float y = 0.0f;			///< ϴͬy
+			CellKey cell = 0;		///< 
+			size_t slot = 0;		///< е±
+		};
+		int CellCoord(float v)const
+		{
+			return static_cast<int>(std::floor(v * _inv_cell_size));
+		}
+		static CellKey MakeKey(int cx, int cy)
+		{
+			return (static_cast<CellKey>(cx) << 32) | static_cast<std::uint32_t>(cy);
+		}
+		CellKey CellOf(float x, float y)const
+		{
+			return MakeKey(CellCoord(x), CellCoord(y));
+		}
+		/**
+		 * @brief ʵ
+		 */
+		void Link(EntityID entity, Entry& entry)
+		{
+			auto& cell = _cells[entry.cell];
+			entry.slot = cell.size();
+			cell.push_back(CellItem{ entity, entry.x, entry.y });
+			if (cell.size() == 1)
+			{
+				_columns[static_cast<int>(entry.cell >> 32)]++;
+				_rows[static_cast<int>(static_cast<std::uint32_t>(entry.cell))]++;
+				UpdateBounds();
+			}
+		}
+		/**
+		 * @brief ʵժ
+		 */
+		void Unlink(const Entry& entry)
+		{
+			auto it = _cells.find(entry.cell);
+			auto& cell = it->second;
+			if (entry.slot + 1 != cell.size())
+			{
+				cell[entry.slot] = cell.back();
+				_entrys[cell[entry.slot].entity].slot = entry.slot;
+			}
+			cell.pop_back();
+			if (cell.empty())
+			{
+				_cells.erase(it);
+				auto column = _columns.find(static_cast<int>(entry.cell >> 32));
+				if (--column->second == 0)
+				{
+					_columns.erase(column);
+				}
+				auto row = _rows.find(static_cast<int>(static_cast<std::uint32_t>(entry.cell)));
+				if (--row->second == 0)
+				{
+					_rows.erase(row);
+				}
+				UpdateBounds();
+			}
+		}
+		/**
+		 * @brief ɷǿмΧ
+		 */
+		void UpdateBounds()
+		{
+			if (_columns.empty())
+			{
+				_min_x = _min_y = 0;
+				_max_x = _max_y = -1;
+				return;
+			}
+			_min_x = _columns.begin()->first;
+			_max_x = _columns.rbegin()->first;
+			_min_y = _rows.begin()->first;
+			_max_y = _rows.rbegin()->first;
+		}
+		/**
+		 * @brief Χڵʵ
+		 */
+		template<typename Func>
+		void ForEachCell(int min_x, int min_y, int max_x, int max_y, Func&& func)const
+		{
+			min_x = std::max(min_x, _min_x);
+			min_y = std::max(min_y, _min_y);
+			max_x = std::min(max_x, _max_x);
+			max_y = std::min(max_y, _max_y);
+			for (int cx = min_x; cx <= max_x; cx++)
+			{
+				for (int cy = min_y; cy <= max_y; cy++)
+				{
+					if (auto it = _cells.find(MakeKey(cx, cy));
+						it != _cells.end())
+					{
+						for (auto& item : it->second)
+						{
+							func(item);
+						}
+					}
+				}
+			}
+		}
+		void QueryRadius(float x, float y, float radius, std::vector<EntityID>& entity_list)const
+		{
+			float sq = radius * radius;
+			ForEachCell(CellCoord(x - radius), CellCoord(y - radius),
+				CellCoord(x + radius), CellCoord(y + radius), [&](const CellItem& item)
+				{
+					float dx = item.x - x;
+					float dy = item.y - y;
+					if (dx * dx + dy * dy <= sq)
+					{
+						entity_list.push_back(item.entity);
+					}
+				});
+		}
+		void QueryAABB(SpatialPoint min, SpatialPoint max, std::vector<EntityID>& entity_list)const
+		{
+			ForEachCell(CellCoord(min.x), CellCoord(min.y),
+				CellCoord(max.x), CellCoord(max.y), [&](const CellItem& item)
+				{
+					if (item.x >= min.x && item.x <= max.x && item.y >= min.y && item.y <= max.y)
+					{
+						entity_list.push_back(item.entity);
+					}
+				});
+		}
+		/**
+		 * @brief ɲѯȦ, Ȧⲻܴڸʵҵȫʵʱֹͣ
+		 *
+		 * Ȧҵǿ, ʣಿָΪֱӱǿ, ʹϡֲʱĴ۲ʵ
+		 */
+		void QueryNearest(float x, float y, size_t k, std::vector<EntityID>& entity_list)const
+		{
+			if (k == 0 || _entrys.empty())
+			{
+				return;
+			}
+			using Candidate = std::pair<float, EntityID>;
+			std::priority_queue<Candidate> heap;	///< ԾƽΪĴ
+			auto visit = [&](const CellItem& item)
+			{
+				float dx = item.x - x;
+				float dy = item.y - y;
+				float sq = dx * dx + dy * dy;
+				if (heap.size() < k)
+				{
+					heap.emplace(sq, item.entity);
+				}
+				else if (sq < heap.top().first)
+				{
+					heap.pop();
+					heap.emplace(sq, item.entity);
+				}
+			};
+			int cx = CellCoord(x);
+			int cy = CellCoord(y);
+			int max_ring = std::max({ std::abs(cx - _min_x), std::abs(cx - _max_x),
+				std::abs(cy - _min_y), std::abs(cy - _max_y) });
+			for (int ring = 0; ring <= max_ring; ring++)
+			{
+				if (static_cast<size_t>(ring) * ring * 4 > _cells.size())
+				{
+					for (auto& [key, items] : _cells)
+					{
+						int dx = std::abs(static_cast<int>(key >> 32) - cx);
+						int dy = std::abs(static_cast<int>(static_cast<std::uint32_t>(key)) - cy);
+						if (std::max(dx, dy) >= ring)
+						{
+							for (auto& item : items)
+							{
+								visit(item);
+							}
+						}
+					}
+					break;
+				}
+				if (ring == 0)
+				{
+					ForEachCell(cx, cy, cx, cy, visit);
+				}
+				else
+				{
+					ForEachCell(cx - ring, cy - ring, cx + ring, cy - ring, visit);
+					ForEachCell(cx - ring, cy + ring, cx + ring, cy + ring, visit);
+					ForEachCell(cx - ring, cy - ring + 1, cx - ring, cy + ring - 1, visit);
+					ForEachCell(cx + ring, cy - ring + 1, cx + ring, cy + ring - 1, visit);
+				}
+				float reach = ring * _cell_size;
+				if ((heap.size() == k && heap.top().first <= reach * reach) || heap.size() == _entrys.size())
+				{
+					break;
+				}
+			}
+			size_t offset = entity_list.size();
+			entity_list.resize(offset + heap.size());
+			for (size_t i = entity_list.size(); i > offset; i--)
+			{
+				entity_list[i - 1] = heap.top().second;
+				heap.pop();
+			}
+		}
+		/**
+		 * @brief ѯƽ䵽߳볣פ߳, ѯڼֻ
+		 */
+		template<typename Func>
+		static void ParallelFor(size_t count, size_t threads, Func&& func)
+		{
+			if (threads == 0)
+			{
+				threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+			}
+			threads = std::min(threads, count);
+			if (threads <= 1)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					func(i);
+				}
+				return;
+			}
+			SpatialWorkers::Instance().Run(count, threads, [&func](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; i++)
+					{
+						func(i);
+					}
+				});
+		}
+	private:
+		float _cell_size;		///< ߴ
+		float _inv_cell_size;	///< ߴĵ
+		int _min_x = 0;			///< ǿķΧ
+		int _min_y = 0;
+		int _max_x = -1;
+		int _max_y = -1;
+		std::map<int, size_t> _columns;	///< xϵķǿ
+		std::map<int, size_t> _rows;	///< yϵķǿ
+		std::unordered_map<EntityID, Entry> _entrys;			///< ʵ
+		std::unordered_map<CellKey, std::vector<CellItem>> _cells;	///< 
+	};
+	/**
+	 * @brief ռ, λ, ƶά
+	 *
+	 * ΪԴڳ, ϵͳͨ Resource::Get<SpatialIndex<T>>() ȡ
+	 *
+	 * @tparam T λ
+	 */
+	template<typename T>
+	class SpatialPlugin final : public Plugin
+	{
+	public:
+		explicit SpatialPlugin(float cell_size = 1.0f) :_cell_size(cell_size)
+		{}
+		void Bulid(Sence* sence) override
+		{
+			sence->SetResource(SpatialIndex<T>(_cell_size));
+			// صڵʱ, ԴƳصЧ
+			sence->OnAdd<T>([sence](EntityID entity, T& position)
+				{
+					if (auto index = sence->GetResource<SpatialIndex<T>>())
+					{
+						index->Insert(entity, position);
+					}
+				});
+			sence->OnRemove<T>([sence](EntityID entity, T&)
+				{
+					if (auto index = sence->GetResource<SpatialIndex<T>>())
+					{
+						index->Erase(entity);
+					}
+				});
+			sence->OnMove<T>([sence](EntityID entity, T& position)
+				{
+					if (auto index = sence->GetResource<SpatialIndex<T>>())
+					{
+						index->Move(entity, position);
+					}
+				});
+			sence->AddUpdateSystem(SpatialIndex<T>::SyncSystem, AnyChanged<T>{});
+		}
+		void Quit(Sence*) override
+		{}
+	private:
+		float _cell_size;	///< ߴ
+	};
+}
@@ -0,0 +1,224 @@
+/*****************************************************************//**
+ * \file   TanmiEcsTask.hpp
+ * \brief  Эϵͳȴ
+ *
+ * \author tanmika
+ * \date   May 2023
+ *********************************************************************/
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <type_traits>
+#include <utility>
+
+namespace TanmiEngine {
+	using TaskClock = std::chrono::steady_clock;
+	/**
+	 * @brief Эָ̻ʱĵϢ, ɵÿλָǰ
+	 */
+	struct TaskState
+	{
+		int frame = 0;		///< ǰ֡
+		TaskClock::time_point deadline;		///< ֡ЭԤĽֹʱ
+		TaskClock::time_point resume_start;	///< λָĿʼʱ
+	};
+	/**
+	 * @brief Эϵͳķ, , ɳĵָ
+	 */
+	class Task final
+	{
+	public:
+		struct promise_type
+		{
+			TaskState* state = nullptr;		///< Ϣ
+			int wake_frame = 0;				///< ڸָ֡
+			std::function<bool()> poll;		///< ǿʱ践trueſɻָ
+			std::exception_ptr error;		///< Эδ쳣
+
+			Task get_return_object()
+			{
+				return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+			std::suspend_always initial_suspend() noexcept
+			{
+				return {};
+			}
+			std::suspend_always final_suspend() noexcept
+			{
+				return {};
+			}
+			void return_void()
+			{}
+			void unhandled_exception()
+			{
+				error = std::current_exception();
+			}
+			/**
+			 * @brief Ƿڱָ֡
+			 */
+			bool Ready(int frame)
+			{
+				if (frame < wake_frame)
+				{
+					return false;
+				}
+				if (poll)
+				{
+					if (!poll())
+					{
+						return false;
+					}
+					poll = nullptr;
+				}
+				return true;
+			}
+		};
+		using Handle = std::coroutine_handle<promise_type>;
+
+		Task() = default;
+		Task(const Task&) = delete;
+		Task& operator = (const Task&) = delete;
+		Task(Task&& other) noexcept :_handle(std::exchange(other._handle, nullptr))
+		{}
+		Task& operator = (Task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				_handle = std::exchange(other._handle, nullptr);
+			}
+			return *this;
+		}
+		~Task()
+		{
+			Reset();
+		}
+		/**
+		 * @brief ǷδЭ
+		 */
+		explicit operator bool() const
+		{
+			return _handle && !_handle.done();
+		}
+		/**
+		 * @brief Э֡
+		 */
+		void Reset()
+		{
+			if (_handle)
+			{
+				_handle.destroy();
+				_handle = nullptr;
+			}
+		}
+		Handle GetHandle() const
+		{
+			return _handle;
+		}
+	private:
+		explicit Task(Handle handle) :_handle(handle)
+		{}
+		Handle _handle = nullptr;
+	};
+	/**
+	 * @brief ȴָ֡
+	 */
+	class NextFrame final
+	{
+	public:
+		/**
+		 * @param count ȴ֡
+		 */
+		explicit NextFrame(int count = 1) :_count(count)
+		{}
+		bool await_ready() const noexcept
+		{
+			return _count <= 0;
+		}
+		void await_suspend(Task::Handle handle) const noexcept
+		{
+			auto& promise = handle.promise();
+			promise.wake_frame = promise.state->frame + _count;
+		}
+		void await_resume() const noexcept
+		{}
+	private:
+		int _count;
+	};
+	/**
+	 * @brief ʱƬ, ֡ЭԤ򱾴λָʱƬδʱִ, һ֡
+	 *
+	 * ڳѭз̯,  for (...) { ; co_await TimeSlice(); }
+	 */
+	class TimeSlice final
+	{
+	public:
+		/**
+		 * @param limit λִָеʱ, Ϊʱֻܱ֡ЭԤ
+		 */
+		explicit TimeSlice(std::chrono::microseconds limit = std::chrono::microseconds::zero()) :_limit(limit)
+		{}
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+		bool await_suspend(Task::Handle handle) const noexcept
+		{
+			auto& promise = handle.promise();
+			auto& state = *promise.state;
+			auto now = TaskClock::now();
+			bool expired = now >= state.deadline
+				|| (_limit.count() > 0 && now - state.resume_start >= _limit);
+			if (!expired)
+			{
+				return false;
+			}
+			promise.wake_frame = state.frame + 1;
+			return true;
+		}
+		void await_resume() const noexcept
+		{}
+	private:
+		std::chrono::microseconds _limit;
+	};
+	/**
+	 * @brief ڹִ߳, ɺָ֡Э̲ؽ
+	 *
+	 * ڹ߳, ÷ʳ; ߳ϽЭ
+	 *
+	 * @tparam F 
+	 */
+	template<typename F>
+	class WorkerJob final
+	{
+	public:
+		using Result = std::invoke_result_t<F>;
+		explicit WorkerJob(F func) :_func(std::move(func))
+		{}
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+		void await_suspend(Task::Handle handle)
+		{
+			_future = std::async(std::launch::async, std::move(_func));
+			handle.promise().poll = [this]()
+			{
+				return _future.wait_for(std::chrono::seconds::zero()) == std::future_status::ready;
+			};
+		}
+		Result await_resume()
+		{
+			return _future.get();
+		}
+	private:
+		F _func;
+		std::future<Result> _future;
+	};
+	template<typename F>
+	WorkerJob(F) -> WorkerJob<F>;
+}
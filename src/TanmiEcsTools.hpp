@@ -8,7 +8,12 @@
 #pragma once
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <optional>
+#include <tuple>
+#include <utility>
 
 #define assertm(exp, msg) assert(((void)msg, exp))
 
@@ -26,7 +31,7 @@ namespace TanmiEngine {
 			return id;
 		}
 	private:
-		inline static int _idx = 0;
+		inline static std::atomic<int> _idx = 0;
 	};
 	/**
 	 * @brief ͬͲͬΨһID
@@ -40,8 +45,71 @@ namespace TanmiEngine {
 			return _id++;
 		}
 	private:
-		inline static T _id = {};
+		inline static std::atomic<T> _id = {};
 	};
+	/**
+	 * @brief 仯ʱ, ȫֵ, ڱһα仯ʱ
+	 */
+	class ChangeTick final
+	{
+	public:
+		using Tick = std::uint64_t;
+		static Tick Next()
+		{
+			return ++_tick;
+		}
+		static Tick Now()
+		{
+			return _tick;
+		}
+	private:
+		inline static Tick _tick = 0;
+	};
+	/**
+	 * @brief ȡɵöĲб
+	 */
+	template<typename F>
+	struct FunctionTraits : FunctionTraits<decltype(&F::operator())>
+	{};
+	template<typename R, typename ...Args>
+	struct FunctionTraits<R(*)(Args...)>
+	{
+		using ArgsTuple = std::tuple<Args...>;
+	};
+	template<typename C, typename R, typename ...Args>
+	struct FunctionTraits<R(C::*)(Args...)>
+	{
+		using ArgsTuple = std::tuple<Args...>;
+	};
+	template<typename C, typename R, typename ...Args>
+	struct FunctionTraits<R(C::*)(Args...)const>
+	{
+		using ArgsTuple = std::tuple<Args...>;
+	};
+	/**
+	 * @brief ΪԪԤ, ʱٷ, ÿ֡ʱ·
+	 *
+	 * @param container vector  unordered_map
+	 * @param count Ԫ
+	 */
+	template<typename Container>
+	void ReserveMore(Container& container, size_t count)
+	{
+		size_t need = container.size() + count;
+		size_t capacity;
+		if constexpr (requires { container.capacity(); })
+		{
+			capacity = container.capacity();
+		}
+		else
+		{
+			capacity = static_cast<size_t>(container.bucket_count() * container.max_load_factor());
+		}
+		if (need > capacity)
+		{
+			container.reserve(std::max(need, container.size() * 2));
+		}
+	}
 	/**
 	* @brief 
 	*/
@@ -54,6 +122,8 @@ namespace TanmiEngine {
 
 		createFunc create_f;			///< ĺ
 		destoryFunc destory_f;			///< ٶĺ
+		destoryFunc recycle_f = nullptr;	///< յʱĴ, Ϊ
+		std::vector<std::pair<char*, char*>> blocks;	///< Ŷڴ, ڶһͷ
 		/**
 		 * @brief 󲢷
 		 *
@@ -72,6 +142,29 @@ namespace TanmiEngine {
 			}
 			return instances.back();
 		}
+		/**
+		 * @brief ӹڳ create_f ͬʽĶ
+		 *
+		 * @param elem 
+		 */
+		void adopt(void* elem)
+		{
+			instances.push_back(elem);
+		}
+		/**
+		 * @brief Ԥȴ뻺, ʹ֮Ĵ
+		 *
+		 * @param count ҪĻ
+		 */
+		void reserve(size_t count)
+		{
+			instances.reserve(instances.size() + count);
+			cache.reserve(count);
+			while (cache.size() < count)
+			{
+				cache.push_back(create_f());
+			}
+		}
 		/**
 		 * @brief ɾָ
 		 *
@@ -82,6 +175,7 @@ namespace TanmiEngine {
 			if (auto it = std::find(instances.begin(), instances.end(), elem);
 				it != instances.end())
 			{
+				recycle(elem);
 				std::swap(*it, instances.back());
 				cache.push_back(instances.back());
 				instances.pop_back();
@@ -91,12 +185,116 @@ namespace TanmiEngine {
 				assertm("element is not found", false);
 			}
 		}
+		/**
+		 * @brief ȫö
+		 */
+		void clear()
+		{
+			for (auto elem : instances)
+			{
+				recycle(elem);
+			}
+			cache.insert(cache.end(), instances.begin(), instances.end());
+			instances.clear();
+		}
+		/**
+		 * @brief ɾ, ֻһοöб
+		 *
+		 * @param elems ɾĶ, ú
+		 */
+		void destory(std::vector<void*>& elems)
+		{
+			std::sort(elems.begin(), elems.end());
+			auto it = std::partition(instances.begin(), instances.end(), [&](void* elem)
+				{
+					return !std::binary_search(elems.begin(), elems.end(), elem);
+				});
+			std::for_each(it, instances.end(), [this](void* elem)
+				{
+					recycle(elem);
+				});
+			cache.insert(cache.end(), it, instances.end());
+			instances.erase(it, instances.end());
+		}
 
-		Pool(createFunc crt, destoryFunc des) :create_f(crt), destory_f(des)
+		Pool(createFunc crt, destoryFunc des, destoryFunc rec = nullptr) :create_f(crt), destory_f(des), recycle_f(rec)
 		{
 			assertm("create function cann't be empty", create_f);
 			assertm("destory function cann't be empty", destory_f);
 		}
+	private:
+		void recycle(void* elem)
+		{
+			if (recycle_f)
+			{
+				recycle_f(elem);
+			}
+		}
+	};
+	/**
+	 * @brief յػʱĴ, Ĭϱԭȴ
+	 *
+	 * ⲿԴػģ, ڻʱǰͷԴ
+	 */
+	template<typename T>
+	struct PoolRecycle
+	{
+		static constexpr destoryFunc func = nullptr;
+	};
+	/**
+	 * @brief Ͳ
+	 */
+	struct ComponentOps final
+	{
+		createFunc create;			///< 
+		destoryFunc destory;		///< ٵ
+		void (*copy)(void*, const void*);	///< ƶֵ
+		void (*move)(void*, void*);			///< ƶֵ
+		void* (*create_array)(size_t);		///< 
+		destoryFunc destory_array;	///< 
+		size_t size;				///< С
+		destoryFunc recycle;		///< յػʱĴ, Ϊ
+
+		template<typename T>
+		static const ComponentOps* Get()
+		{
+			static const ComponentOps ops{
+				[]() -> void*
+				{
+					return new T();
+				},
+				[](void* elem)
+				{
+					delete static_cast<T*>(elem);
+				},
+				[](void* dst, const void* src)
+				{
+					*static_cast<T*>(dst) = *static_cast<const T*>(src);
+				},
+				[](void* dst, void* src)
+				{
+					*static_cast<T*>(dst) = std::move(*static_cast<T*>(src));
+				},
+				[](size_t count) -> void*
+				{
+					return new T[count];
+				},
+				[](void* elems)
+				{
+					delete[] static_cast<T*>(elems);
+				},
+				sizeof(T),
+				PoolRecycle<T>::func
+			};
+			return &ops;
+		}
+		/**
+		 * @brief ȡеĵindex
+		 */
+		void* At(void* elems, size_t index)const
+		{
+			return static_cast<char*>(elems) + index * size;
+		}
 	};
 	template<typename T>
 	class EventMessage final
@@ -118,6 +316,13 @@ namespace TanmiEngine {
 		{
 			return _msg.has_value();
 		};
+		/**
+		 * @brief һյ¼ʱ
+		 */
+		static ChangeTick::Tick LastUpdate()
+		{
+			return _tick;
+		}
 		static void Clear()
 		{
 			_msg = std::nullopt;
@@ -129,10 +334,12 @@ namespace TanmiEngine {
 			{
 				_msg = _msg_next;
 				_msg_next = std::nullopt;
+				_tick = ChangeTick::Next();
 			}
 		};
 	private:
 		inline static std::optional<T> _msg = std::nullopt;
 		inline static std::optional<T> _msg_next = std::nullopt;
+		inline static ChangeTick::Tick _tick = 0;	///< һյ¼ʱ
 	};
 }
\ No newline at end of file